@@ -4,6 +4,33 @@
 #include <sstream>
 #include <climits>
 #include <exception>
+#include <string_view>
+#include <charconv>
+#include <stdexcept>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <iomanip>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 using namespace std;
 
 struct TreeNode {
@@ -16,188 +43,1659 @@ struct TreeNode {
         : id(id_val), x(x_val), y(y_val), left(nullptr), right(nullptr) {}
 };
 
+// Разбор входа за один проход прямо по string_view, без промежуточного вектора токенов.
+// Числа читаются через from_chars: без локали, без исключений внутри и без выделения памяти.
+class TreeParser {
+    string_view input;
+    size_t pos;
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    void skipSpaces() {
+        while (pos < input.size() && isSpace(input[pos])) pos++;
+    }
+
+    string_view nextToken() {
+        skipSpaces();
+        size_t start = pos;
+        while (pos < input.size() && !isSpace(input[pos])) pos++;
+        return input.substr(start, pos - start);
+    }
+
+    template <typename T>
+    T readNumber() {
+        string_view token = nextToken();
+        T value{};
+        auto result = from_chars(token.data(), token.data() + token.size(), value);
+        if (token.empty() || result.ec != errc() || result.ptr != token.data() + token.size()) {
+            throw invalid_argument("некорректное число: '" + string(token) + "'");
+        }
+        return value;
+    }
+
+public:
+    explicit TreeParser(string_view text) : input(text), pos(0) {}
+
+    bool atEnd() {
+        skipSpaces();
+        return pos >= input.size();
+    }
+
+    // Число узлов в оставшемся входе (каждый узел - три токена, "#" не считается),
+    // чтобы выделить память под все узлы сразу
+    size_t countNodes() const {
+        size_t tokens = 0;
+        bool inToken = false;
+        for (size_t i = pos; i < input.size(); i++) {
+            bool space = isSpace(input[i]);
+            if (!space && !inToken) {
+                bool isNull = input[i] == '#' && (i + 1 == input.size() || isSpace(input[i + 1]));
+                if (!isNull) tokens++;
+            }
+            inToken = !space;
+        }
+        return tokens / 3;
+    }
+
+    // Пропускает маркер пустого поддерева "#", если он следующий
+    bool consumeNull() {
+        skipSpaces();
+        if (pos < input.size() && input[pos] == '#' &&
+            (pos + 1 == input.size() || isSpace(input[pos + 1]))) {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+
+    int readInt() {
+        return readNumber<int>();
+    }
+
+    double readDouble() {
+        return readNumber<double>();
+    }
+};
+
+// Файл, отображённый в память только для чтения: разбор идёт прямо по страницам файла
+class MappedFile {
+    const char* data_;
+    size_t size_;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+
+public:
+    explicit MappedFile(const string& path) : data_(nullptr), size_(0) {
+#ifdef _WIN32
+        mapping = nullptr;
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) throw runtime_error("не удалось открыть файл " + path);
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            CloseHandle(file);
+            throw runtime_error("не удалось узнать размер файла " + path);
+        }
+        size_ = (size_t)fileSize.QuadPart;
+        if (size_ > 0) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mapping) {
+                CloseHandle(file);
+                throw runtime_error("не удалось отобразить файл " + path);
+            }
+            data_ = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (!data_) {
+                CloseHandle(mapping);
+                CloseHandle(file);
+                throw runtime_error("не удалось отобразить файл " + path);
+            }
+        }
+#else
+        fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw runtime_error("не удалось открыть файл " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw runtime_error("не удалось узнать размер файла " + path);
+        }
+        size_ = (size_t)st.st_size;
+        if (size_ > 0) {
+            void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                close(fd);
+                throw runtime_error("не удалось отобразить файл " + path);
+            }
+            madvise(addr, size_, MADV_SEQUENTIAL);
+            data_ = (const char*)addr;
+        }
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+#else
+        if (data_) munmap((void*)data_, size_);
+        close(fd);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    string_view view() const {
+        return string_view(data_, size_);
+    }
+};
+
+// Все обходы ниже итеративные, с явным стеком в куче:
+// вырожденное дерево (цепочка) любой глубины не переполняет стек вызовов.
+
 class TreeBuilder {
 public:
-    static TreeNode* buildTree(vector<string>& tokens, int& index) {
-        if (index >= tokens.size()) return nullptr;
-        if (tokens[index] == "#") {
-            index++;
-            return nullptr;
+    static TreeNode* buildTree(TreeParser& parser) {
+        TreeNode* root = nullptr;
+        // стек мест, куда нужно записать очередное поддерево в порядке preorder
+        vector<TreeNode**> slots = {&root};
+
+        while (!slots.empty()) {
+            TreeNode** slot = slots.back();
+            slots.pop_back();
+            if (parser.atEnd()) continue;
+            if (parser.consumeNull()) continue;
+
+            int id = parser.readInt();
+            double x = parser.readDouble();
+            double y = parser.readDouble();
+
+            TreeNode* node = new TreeNode(id, x, y);
+            *slot = node;
+            slots.push_back(&node->right);
+            slots.push_back(&node->left);
         }
-        
-        int id = stoi(tokens[index++]);
-        double x = stod(tokens[index++]);
-        double y = stod(tokens[index++]);
+        return root;
+    }
+};
 
-        TreeNode* node = new TreeNode(id, x, y);
-        node->left = buildTree(tokens, index);
-        node->right = buildTree(tokens, index);
-        return node;
+
+// Узел компактной раскладки: все узлы лежат в одном векторе,
+// дети задаются 32-битными индексами вместо 8-байтных указателей (32 байта против 40)
+struct CompactNode {
+    double x, y;
+    int id;
+    uint32_t left, right;
+};
+
+// Дерево-арена: узлы в порядке preorder (корень - nodes[0]), освобождается одним вызовом
+class CompactTree {
+public:
+    static const uint32_t NIL = UINT32_MAX;
+
+    vector<CompactNode> nodes;
+
+    static CompactTree parse(TreeParser& parser) {
+        CompactTree tree;
+        tree.nodes.reserve(parser.countNodes());
+        // слот = индекс родителя * 2 + (1, если это правый ребёнок); ROOT - место корня
+        const uint64_t ROOT = UINT64_MAX;
+        vector<uint64_t> slots = {ROOT};
+
+        while (!slots.empty()) {
+            uint64_t slot = slots.back();
+            slots.pop_back();
+            if (parser.atEnd()) continue;
+            if (parser.consumeNull()) continue;
+
+            int id = parser.readInt();
+            double x = parser.readDouble();
+            double y = parser.readDouble();
+
+            if (tree.nodes.size() >= NIL) throw length_error("слишком много узлов для 32-битных индексов");
+            uint32_t index = (uint32_t)tree.nodes.size();
+            tree.nodes.push_back({x, y, id, NIL, NIL});
+            if (slot != ROOT) {
+                CompactNode& parent = tree.nodes[slot >> 1];
+                (slot & 1 ? parent.right : parent.left) = index;
+            }
+            slots.push_back(uint64_t(index) * 2 + 1);
+            slots.push_back(uint64_t(index) * 2);
+        }
+        return tree;
+    }
+
+    static CompactTree fromTree(TreeNode* root) {
+        CompactTree tree;
+        const uint64_t ROOT = UINT64_MAX;
+        vector<pair<TreeNode*, uint64_t>> stack;
+        if (root) stack.push_back({root, ROOT});
+
+        while (!stack.empty()) {
+            auto [node, slot] = stack.back();
+            stack.pop_back();
+            uint32_t index = (uint32_t)tree.nodes.size();
+            tree.nodes.push_back({node->x, node->y, node->id, NIL, NIL});
+            if (slot != ROOT) {
+                CompactNode& parent = tree.nodes[slot >> 1];
+                (slot & 1 ? parent.right : parent.left) = index;
+            }
+            if (node->right) stack.push_back({node->right, uint64_t(index) * 2 + 1});
+            if (node->left) stack.push_back({node->left, uint64_t(index) * 2});
+        }
+        return tree;
+    }
+
+    bool empty() const {
+        return nodes.empty();
+    }
+
+    uint32_t root() const {
+        return nodes.empty() ? NIL : 0;
+    }
+
+    size_t memoryBytes() const {
+        return nodes.capacity() * sizeof(CompactNode);
+    }
+};
+
+// Способы навигации по разным раскладкам дерева, чтобы обходы TreeAnalyzer
+// были написаны один раз: Ref - ссылка на узел, null() - пустое поддерево
+struct PointerLayout {
+    using Ref = TreeNode*;
+
+    Ref null() const { return nullptr; }
+    int id(Ref node) const { return node->id; }
+    Ref left(Ref node) const { return node->left; }
+    Ref right(Ref node) const { return node->right; }
+};
+
+struct CompactLayout {
+    using Ref = uint32_t;
+    const CompactNode* nodes;
+
+    Ref null() const { return CompactTree::NIL; }
+    int id(Ref node) const { return nodes[node].id; }
+    Ref left(Ref node) const { return nodes[node].left; }
+    Ref right(Ref node) const { return nodes[node].right; }
+};
+
+// Двоичный формат дерева:
+//   заголовок: "TREEBIN1", число узлов n, число позиций структуры (n + пустые поддеревья)
+//   структура: по биту на позицию preorder (1 - узел, 0 - "#"), слова по 64 бита
+//   столбцы: id (int32, дополнено до 8 байт), затем x и y (double) в порядке preorder
+// Все части выровнены по 8 байтам, поэтому файл читается прямо из отображения в память.
+struct BinaryTreeHeader {
+    char magic[8];
+    uint64_t nodeCount;
+    uint64_t slotCount;
+};
+
+class BinaryTreeWriter {
+public:
+    static void write(const CompactTree& tree, const string& path) {
+        CompactLayout layout{tree.nodes.data()};
+        vector<uint64_t> bits;
+        vector<int32_t> ids;
+        vector<double> xs, ys;
+        ids.reserve(tree.nodes.size());
+        xs.reserve(tree.nodes.size());
+        ys.reserve(tree.nodes.size());
+
+        uint64_t slot = 0;
+        vector<uint32_t> stack = {tree.root()};
+        while (!stack.empty()) {
+            uint32_t node = stack.back();
+            stack.pop_back();
+            if (slot % 64 == 0) bits.push_back(0);
+            if (node != layout.null()) {
+                bits.back() |= uint64_t(1) << (slot % 64);
+                ids.push_back(tree.nodes[node].id);
+                xs.push_back(tree.nodes[node].x);
+                ys.push_back(tree.nodes[node].y);
+                stack.push_back(layout.right(node));
+                stack.push_back(layout.left(node));
+            }
+            slot++;
+        }
+        if (ids.size() % 2) ids.push_back(0);
+
+        BinaryTreeHeader header = {{'T', 'R', 'E', 'E', 'B', 'I', 'N', '1'}, xs.size(), slot};
+        FILE* out = fopen(path.c_str(), "wb");
+        if (!out) throw runtime_error("не удалось создать файл " + path);
+        // Пустые столбцы пропускаются: fwrite с nullptr недопустим даже при нулевой длине
+        auto column = [out](const void* data, size_t size, size_t count) {
+            return count == 0 || fwrite(data, size, count, out) == count;
+        };
+        bool written = column(&header, sizeof(header), 1) &&
+                       column(bits.data(), sizeof(uint64_t), bits.size()) &&
+                       column(ids.data(), sizeof(int32_t), ids.size()) &&
+                       column(xs.data(), sizeof(double), xs.size()) &&
+                       column(ys.data(), sizeof(double), ys.size());
+        if (fclose(out) != 0 || !written) throw runtime_error("ошибка записи файла " + path);
+    }
+};
+
+// Дерево в двоичном формате без копирования: указатели смотрят прямо в отображённый файл
+class BinaryTreeView {
+public:
+    uint64_t nodeCount;
+    uint64_t slotCount;
+    const uint64_t* bits;
+    const int32_t* ids;
+    const double* xs;
+    const double* ys;
+
+    explicit BinaryTreeView(string_view data) {
+        if (data.size() < sizeof(BinaryTreeHeader) || memcmp(data.data(), "TREEBIN1", 8) != 0) {
+            throw runtime_error("файл не в формате TREEBIN1");
+        }
+        BinaryTreeHeader header;
+        memcpy(&header, data.data(), sizeof(header));
+        nodeCount = header.nodeCount;
+        slotCount = header.slotCount;
+
+        // Каждый узел занимает не меньше 16 байт координат, поэтому такое ограничение сверху
+        // выполняется для любого целого файла и исключает переполнение в дальнейших формулах
+        uint64_t payload = data.size() - sizeof(header);
+        if (nodeCount > payload / 16 || slotCount / 2 != nodeCount || slotCount % 2 != 1) {
+            throw runtime_error("повреждённый файл TREEBIN1");
+        }
+        uint64_t bitWords = slotCount / 64 + (slotCount % 64 != 0);
+        uint64_t idWords = nodeCount / 2 + nodeCount % 2;
+        if (payload / 8 != bitWords + idWords + 2 * nodeCount || payload % 8 != 0) {
+            throw runtime_error("повреждённый файл TREEBIN1");
+        }
+
+        const char* p = data.data() + sizeof(header);
+        bits = reinterpret_cast<const uint64_t*>(p);
+        ids = reinterpret_cast<const int32_t*>(p + 8 * bitWords);
+        xs = reinterpret_cast<const double*>(p + 8 * (bitWords + idWords));
+        ys = xs + nodeCount;
+
+        // Битовая строка должна быть корректным preorder: каждый узел открывает два слота,
+        // слоты заканчиваются ровно на последнем бите и единиц ровно nodeCount
+        uint64_t open = 1, nodes = 0;
+        for (uint64_t slot = 0; slot < slotCount; slot++) {
+            if (open == 0) throw runtime_error("повреждённый файл TREEBIN1");
+            open--;
+            if (isNode(slot)) {
+                open += 2;
+                nodes++;
+            }
+        }
+        if (open != 0 || nodes != nodeCount) throw runtime_error("повреждённый файл TREEBIN1");
+    }
+
+    bool isNode(uint64_t slot) const {
+        return (bits[slot / 64] >> (slot % 64)) & 1;
     }
 };
 
+// Результат одного обхода дерева
+struct TreeStats {
+    int nodes = 0;
+    int height = 0;
+    int leaves = 0;
+    int minID = INT_MAX;
+    int maxID = INT_MIN;
+    bool isBST = true;
+};
 
 class TreeAnalyzer {
 public:
-    static int countNodes(TreeNode* root) {
-    if (root == nullptr) {
-        return 0;
-    } else {
-        return 1 + countNodes(root->left) + countNodes(root->right);
+    // Один проход в порядке preorder вместо отдельных countNodes/getHeight/countLeaves/
+    // findMin/findMax/isValidBST. Если передан preorder, в него дописывается
+    // структура дерева для вывода: ID узлов и "#" для пустых поддеревьев через пробел.
+    // depth и границы minVal/maxVal задают положение root, если это поддерево большего дерева.
+    template <typename Layout>
+    static TreeStats analyze(const Layout& layout, typename Layout::Ref root, string* preorder = nullptr,
+                             int depth = 1, long long minVal = LLONG_MIN, long long maxVal = LLONG_MAX) {
+        using Ref = typename Layout::Ref;
+        struct Frame {
+            Ref node;
+            int depth;
+            long long minVal, maxVal;
+        };
+
+        TreeStats stats;
+        vector<Frame> stack = {{root, depth, minVal, maxVal}};
+        char buffer[16];
+        while (!stack.empty()) {
+            Frame frame = stack.back();
+            stack.pop_back();
+            Ref node = frame.node;
+            if (node == layout.null()) {
+                if (preorder) preorder->append("# ");
+                continue;
+            }
+
+            int id = layout.id(node);
+            Ref left = layout.left(node);
+            Ref right = layout.right(node);
+
+            stats.nodes++;
+            stats.height = max(stats.height, frame.depth);
+            stats.minID = min(stats.minID, id);
+            stats.maxID = max(stats.maxID, id);
+            if (left == layout.null() && right == layout.null()) stats.leaves++;
+            if (id <= frame.minVal || id >= frame.maxVal) stats.isBST = false;
+
+            if (preorder) {
+                char* end = to_chars(buffer, buffer + sizeof(buffer), id).ptr;
+                *end++ = ' ';
+                preorder->append(buffer, end - buffer);
+            }
+
+            // пустые поддеревья кладутся в стек только ради вывода "#"
+            if (right != layout.null() || preorder)
+                stack.push_back({right, frame.depth + 1, id, frame.maxVal});
+            if (left != layout.null() || preorder)
+                stack.push_back({left, frame.depth + 1, frame.minVal, id});
+        }
+        return stats;
+    }
+
+    static TreeStats analyze(TreeNode* root, string* preorder = nullptr) {
+        return analyze(PointerLayout{}, root, preorder);
+    }
+
+    // Для компактного дерева узлы читаются из памяти подряд: порядок обхода совпадает с раскладкой
+    static TreeStats analyze(const CompactTree& tree, string* preorder = nullptr) {
+        return analyze(CompactLayout{tree.nodes.data()}, tree.root(), preorder);
     }
+
+    // Анализ двоичного дерева за один последовательный проход по битам структуры.
+    // Узел в позиции slot - лист, если обе следующие позиции пустые.
+    static TreeStats analyze(const BinaryTreeView& tree, string* preorder = nullptr) {
+        struct Frame {
+            int depth;
+            long long minVal, maxVal;
+        };
+
+        TreeStats stats;
+        vector<Frame> stack = {{1, LLONG_MIN, LLONG_MAX}};
+        char buffer[16];
+        uint64_t nodeIndex = 0;
+        for (uint64_t slot = 0; slot < tree.slotCount && !stack.empty(); slot++) {
+            Frame frame = stack.back();
+            stack.pop_back();
+            if (!tree.isNode(slot)) {
+                if (preorder) preorder->append("# ");
+                continue;
+            }
+
+            int id = tree.ids[nodeIndex++];
+            stats.nodes++;
+            stats.height = max(stats.height, frame.depth);
+            stats.minID = min(stats.minID, id);
+            stats.maxID = max(stats.maxID, id);
+            if (!tree.isNode(slot + 1) && !tree.isNode(slot + 2)) stats.leaves++;
+            if (id <= frame.minVal || id >= frame.maxVal) stats.isBST = false;
+
+            if (preorder) {
+                char* end = to_chars(buffer, buffer + sizeof(buffer), id).ptr;
+                *end++ = ' ';
+                preorder->append(buffer, end - buffer);
+            }
+
+            stack.push_back({frame.depth + 1, id, frame.maxVal});
+            stack.push_back({frame.depth + 1, frame.minVal, id});
+        }
+        return stats;
+    }
+
+    static int countNodes(TreeNode* root) {
+        int count = 0;
+        vector<TreeNode*> stack;
+        if (root) stack.push_back(root);
+        while (!stack.empty()) {
+            TreeNode* node = stack.back();
+            stack.pop_back();
+            count++;
+            if (node->right) stack.push_back(node->right);
+            if (node->left) stack.push_back(node->left);
+        }
+        return count;
     }
 
+    // Минимум и максимум ищутся по всем узлам: спуск по левой/правой ветке
+    // верен только для корректного BST
     static int findMinID(TreeNode* root) {
-        if (!root) return INT_MAX;
-        while (root->left) root = root->left;  
-        return root->id;
-}
+        return analyze(root).minID;
+    }
 
     static int findMaxID(TreeNode* root) {
-        if (!root) return INT_MIN;
-        while (root->right) root = root->right;
-        return root->id;
+        return analyze(root).maxID;
     }
 
     static int getHeight(TreeNode* root) {
-        return root ? 1 + max(getHeight(root->left), getHeight(root->right)) : 0;
+        int height = 0;
+        vector<pair<TreeNode*, int>> stack;
+        if (root) stack.push_back({root, 1});
+        while (!stack.empty()) {
+            auto [node, depth] = stack.back();
+            stack.pop_back();
+            height = max(height, depth);
+            if (node->right) stack.push_back({node->right, depth + 1});
+            if (node->left) stack.push_back({node->left, depth + 1});
+        }
+        return height;
     }
 
     static int countLeaves(TreeNode* root) {
-        if (!root) return 0;
-        if (!root->left && !root->right) return 1;
-        return countLeaves(root->left) + countLeaves(root->right);
+        int leaves = 0;
+        vector<TreeNode*> stack;
+        if (root) stack.push_back(root);
+        while (!stack.empty()) {
+            TreeNode* node = stack.back();
+            stack.pop_back();
+            if (!node->left && !node->right) leaves++;
+            if (node->right) stack.push_back(node->right);
+            if (node->left) stack.push_back(node->left);
+        }
+        return leaves;
     }
 
     static bool isValidBST(TreeNode* root, long long minVal = LLONG_MIN, long long maxVal = LLONG_MAX) {
-        if (!root) return true;
-        if (root->id <= minVal || root->id >= maxVal) return false;
-        return isValidBST(root->left, minVal, root->id) && isValidBST(root->right, root->id, maxVal);
+        struct Frame {
+            TreeNode* node;
+            long long minVal, maxVal;
+        };
+        vector<Frame> stack;
+        if (root) stack.push_back({root, minVal, maxVal});
+        while (!stack.empty()) {
+            Frame frame = stack.back();
+            stack.pop_back();
+            TreeNode* node = frame.node;
+            if (node->id <= frame.minVal || node->id >= frame.maxVal) return false;
+            if (node->right) stack.push_back({node->right, node->id, frame.maxVal});
+            if (node->left) stack.push_back({node->left, frame.minVal, node->id});
+        }
+        return true;
+    }
+};
+
+// Пул потоков с перехватом задач (work stealing): у каждого потока своя очередь,
+// свои задачи он берёт с конца (LIFO), чужие забирает с начала (FIFO).
+// Поток, создавший пул, считается потоком 0 и тоже выполняет задачи, пока ждёт результат.
+class WorkStealingPool {
+    struct Queue {
+        mutex mtx;
+        deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<Queue>> queues;
+    vector<thread> workers;
+    atomic<bool> stopping;
+    // Число задач в очередях; свободные рабочие спят на wake, пока оно равно нулю
+    atomic<size_t> queued;
+    mutex sleepMtx;
+    condition_variable wake;
+
+    static int& currentIndex() {
+        static thread_local int index = 0;
+        return index;
+    }
+
+    bool popOwn(int index, function<void()>& task) {
+        Queue& queue = *queues[index];
+        lock_guard<mutex> lock(queue.mtx);
+        if (queue.tasks.empty()) return false;
+        task = move(queue.tasks.back());
+        queue.tasks.pop_back();
+        queued.fetch_sub(1, memory_order_relaxed);
+        return true;
+    }
+
+    bool steal(int thief, function<void()>& task) {
+        int count = (int)queues.size();
+        for (int i = 1; i < count; i++) {
+            Queue& queue = *queues[(thief + i) % count];
+            lock_guard<mutex> lock(queue.mtx);
+            if (queue.tasks.empty()) continue;
+            task = move(queue.tasks.front());
+            queue.tasks.pop_front();
+            queued.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+public:
+    explicit WorkStealingPool(unsigned threads) : stopping(false), queued(0) {
+        threads = max(1u, threads);
+        for (unsigned i = 0; i < threads; i++) queues.push_back(make_unique<Queue>());
+        currentIndex() = 0;
+        for (unsigned i = 1; i < threads; i++) {
+            workers.emplace_back([this, i]() {
+                currentIndex() = (int)i;
+                while (!stopping.load(memory_order_relaxed)) {
+                    if (runOne()) continue;
+                    unique_lock<mutex> lock(sleepMtx);
+                    wake.wait(lock, [this]() { return stopping.load() || queued.load() > 0; });
+                }
+            });
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            lock_guard<mutex> lock(sleepMtx);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    unsigned size() const {
+        return (unsigned)queues.size();
+    }
+
+    void spawn(function<void()> task) {
+        {
+            Queue& queue = *queues[currentIndex()];
+            lock_guard<mutex> lock(queue.mtx);
+            queue.tasks.push_back(move(task));
+            queued.fetch_add(1);
+        }
+        // Захват sleepMtx не даёт рабочему уснуть между проверкой queued и ожиданием
+        { lock_guard<mutex> lock(sleepMtx); }
+        wake.notify_one();
+    }
+
+    // Выполняет одну задачу, если она нашлась
+    bool runOne() {
+        function<void()> task;
+        int index = currentIndex();
+        if (popOwn(index, task) || steal(index, task)) {
+            task();
+            return true;
+        }
+        return false;
+    }
+
+    // Ожидание без простоя: пока done() ложно, поток выполняет другие задачи
+    template <typename Pred>
+    void helpUntil(Pred done) {
+        while (!done()) {
+            if (!runOne()) this_thread::yield();
+        }
+    }
+};
+
+// Параллельный анализ компактного дерева: поддеревья больше cutoff узлов
+// делятся на задачи, частичные результаты объединяются.
+// В раскладке preorder поддерево узла i занимает отрезок [i, end), поэтому
+// размер любого поддерева известен без дополнительного прохода.
+class ParallelTreeAnalyzer {
+    static TreeStats combine(int id, int depth, long long minVal, long long maxVal,
+                             const TreeStats& left, const TreeStats& right) {
+        TreeStats stats;
+        stats.nodes = 1 + left.nodes + right.nodes;
+        stats.height = max(depth, max(left.height, right.height));
+        stats.leaves = (left.nodes == 0 && right.nodes == 0) ? 1 : left.leaves + right.leaves;
+        stats.minID = min(id, min(left.minID, right.minID));
+        stats.maxID = max(id, max(left.maxID, right.maxID));
+        stats.isBST = id > minVal && id < maxVal && left.isBST && right.isBST;
+        return stats;
+    }
+
+    // Узел пути, пройденного без разветвления: его меньшее поддерево уже посчитано
+    struct PathStep {
+        int id;
+        int depth;
+        long long minVal, maxVal;
+        TreeStats small;
+        bool smallIsLeft;
+    };
+
+    // В пул отдаётся только узел, у которого оба поддерева больше cutoff; если одно из них
+    // меньше, оно считается сразу, а спуск в большее идёт циклом. Поэтому на вырожденном дереве
+    // глубина рекурсии не растёт с числом узлов (каждая развилка отнимает больше cutoff узлов)
+    static TreeStats analyzeRange(const CompactTree& tree, WorkStealingPool& pool, size_t cutoff,
+                                  uint32_t node, uint32_t end, int depth, long long minVal, long long maxVal) {
+        CompactLayout layout{tree.nodes.data()};
+        vector<PathStep> path;
+        TreeStats result;
+
+        while (true) {
+            if (end - node <= cutoff) {
+                result = TreeAnalyzer::analyze(layout, node, nullptr, depth, minVal, maxVal);
+                break;
+            }
+
+            const CompactNode& current = tree.nodes[node];
+            uint32_t rightStart = current.right == CompactTree::NIL ? end : current.right;
+            size_t leftSize = current.left == CompactTree::NIL ? 0 : rightStart - current.left;
+            size_t rightSize = end - rightStart;
+
+            if (leftSize > cutoff && rightSize > cutoff) {
+                // правое поддерево отдаётся в пул, левое считается в этом же потоке
+                TreeStats left, right;
+                atomic<bool> rightDone(false);
+                pool.spawn([&]() {
+                    right = analyzeRange(tree, pool, cutoff, rightStart, end, depth + 1, current.id, maxVal);
+                    rightDone.store(true, memory_order_release);
+                });
+                left = analyzeRange(tree, pool, cutoff, current.left, rightStart, depth + 1, minVal, current.id);
+                pool.helpUntil([&]() { return rightDone.load(memory_order_acquire); });
+                result = combine(current.id, depth, minVal, maxVal, left, right);
+                break;
+            }
+
+            PathStep step{current.id, depth, minVal, maxVal, TreeStats(), leftSize < rightSize};
+            if (step.smallIsLeft) {
+                if (leftSize > 0) step.small = TreeAnalyzer::analyze(layout, current.left, nullptr, depth + 1, minVal, current.id);
+                node = rightStart;
+                minVal = current.id;
+            } else {
+                if (rightSize > 0) step.small = TreeAnalyzer::analyze(layout, rightStart, nullptr, depth + 1, current.id, maxVal);
+                node = current.left;
+                end = rightStart;
+                maxVal = current.id;
+            }
+            depth++;
+            path.push_back(step);
+        }
+
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            result = it->smallIsLeft ? combine(it->id, it->depth, it->minVal, it->maxVal, it->small, result)
+                                     : combine(it->id, it->depth, it->minVal, it->maxVal, result, it->small);
+        }
+        return result;
+    }
+
+public:
+    static TreeStats analyze(const CompactTree& tree, WorkStealingPool& pool, size_t cutoff = 1 << 16) {
+        if (tree.empty()) return TreeStats();
+        return analyzeRange(tree, pool, max<size_t>(cutoff, 1), 0, (uint32_t)tree.nodes.size(),
+                            1, LLONG_MIN, LLONG_MAX);
+    }
+};
+
+// Пространственный индекс по координатам (x, y) узлов: неявное k-d дерево в плоском массиве.
+// Отрезок [lo, hi) массива - поддерево, его медиана mid - узел, который делит точки
+// по оси x (чётная глубина) или y (нечётная); слева точки не больше, справа не меньше.
+class SpatialIndex {
+public:
+    struct Point {
+        double x, y;
+        int id;
+    };
+
+    struct Rect {
+        double minX, minY, maxX, maxY;
+    };
+
+private:
+    vector<Point> points;
+
+    static double coord(const Point& p, int axis) {
+        return axis == 0 ? p.x : p.y;
+    }
+
+    struct Range {
+        size_t lo, hi;
+        int axis;
+    };
+
+    void build() {
+        vector<Range> stack;
+        if (!points.empty()) stack.push_back({0, points.size(), 0});
+        while (!stack.empty()) {
+            Range r = stack.back();
+            stack.pop_back();
+            if (r.hi - r.lo <= 1) continue;
+            size_t mid = r.lo + (r.hi - r.lo) / 2;
+            nth_element(points.begin() + r.lo, points.begin() + mid, points.begin() + r.hi,
+                        [axis = r.axis](const Point& a, const Point& b) { return coord(a, axis) < coord(b, axis); });
+            stack.push_back({r.lo, mid, 1 - r.axis});
+            stack.push_back({mid + 1, r.hi, 1 - r.axis});
+        }
+    }
+
+public:
+    explicit SpatialIndex(vector<Point> pts) : points(move(pts)) {
+        build();
+    }
+
+    static SpatialIndex fromTree(TreeNode* root) {
+        vector<Point> pts;
+        vector<TreeNode*> stack;
+        if (root) stack.push_back(root);
+        while (!stack.empty()) {
+            TreeNode* node = stack.back();
+            stack.pop_back();
+            pts.push_back({node->x, node->y, node->id});
+            if (node->right) stack.push_back(node->right);
+            if (node->left) stack.push_back(node->left);
+        }
+        return SpatialIndex(move(pts));
+    }
+
+    static SpatialIndex fromTree(const CompactTree& tree) {
+        vector<Point> pts;
+        pts.reserve(tree.nodes.size());
+        for (const auto& node : tree.nodes) pts.push_back({node.x, node.y, node.id});
+        return SpatialIndex(move(pts));
+    }
+
+    size_t size() const {
+        return points.size();
+    }
+
+    // ID всех узлов, попавших в прямоугольник (границы включаются)
+    vector<int> range(const Rect& rect) const {
+        vector<int> result;
+        vector<Range> stack;
+        if (!points.empty()) stack.push_back({0, points.size(), 0});
+        while (!stack.empty()) {
+            Range r = stack.back();
+            stack.pop_back();
+            if (r.lo >= r.hi) continue;
+            size_t mid = r.lo + (r.hi - r.lo) / 2;
+            const Point& p = points[mid];
+            if (p.x >= rect.minX && p.x <= rect.maxX && p.y >= rect.minY && p.y <= rect.maxY) {
+                result.push_back(p.id);
+            }
+            double split = coord(p, r.axis);
+            double low = r.axis == 0 ? rect.minX : rect.minY;
+            double high = r.axis == 0 ? rect.maxX : rect.maxY;
+            if (low <= split) stack.push_back({r.lo, mid, 1 - r.axis});
+            if (high >= split) stack.push_back({mid + 1, r.hi, 1 - r.axis});
+        }
+        return result;
+    }
+
+    // ID k ближайших к (x, y) узлов, от ближнего к дальнему
+    vector<int> nearest(double x, double y, size_t k) const {
+        // max-куча кандидатов: на вершине самый дальний из k лучших
+        vector<pair<double, int>> heap;
+        if (k == 0) return {};
+
+        struct Frame {
+            size_t lo, hi;
+            int axis;
+            double planeDist2; // квадрат расстояния до разделяющей плоскости родителя
+        };
+        vector<Frame> stack;
+        if (!points.empty()) stack.push_back({0, points.size(), 0, 0.0});
+        while (!stack.empty()) {
+            Frame f = stack.back();
+            stack.pop_back();
+            if (f.lo >= f.hi) continue;
+            if (heap.size() == k && f.planeDist2 > heap.front().first) continue;
+
+            size_t mid = f.lo + (f.hi - f.lo) / 2;
+            const Point& p = points[mid];
+            double dx = p.x - x, dy = p.y - y;
+            double dist2 = dx * dx + dy * dy;
+            if (heap.size() < k) {
+                heap.push_back({dist2, p.id});
+                push_heap(heap.begin(), heap.end());
+            } else if (dist2 < heap.front().first) {
+                pop_heap(heap.begin(), heap.end());
+                heap.back() = {dist2, p.id};
+                push_heap(heap.begin(), heap.end());
+            }
+
+            double diff = (f.axis == 0 ? x : y) - coord(p, f.axis);
+            Frame nearSide{f.lo, mid, 1 - f.axis, 0.0};
+            Frame farSide{mid + 1, f.hi, 1 - f.axis, 0.0};
+            if (diff > 0) swap(nearSide, farSide);
+            farSide.planeDist2 = max(f.planeDist2, diff * diff);
+            nearSide.planeDist2 = f.planeDist2;
+            // ближняя половина кладётся последней, чтобы обойти её первой
+            stack.push_back(farSide);
+            stack.push_back(nearSide);
+        }
+
+        sort_heap(heap.begin(), heap.end());
+        vector<int> result;
+        for (auto& candidate : heap) result.push_back(candidate.second);
+        return result;
+    }
+
+    // Пакетные запросы: ответ i соответствует запросу i
+    vector<vector<int>> rangeBatch(const vector<Rect>& rects) const {
+        vector<vector<int>> results;
+        results.reserve(rects.size());
+        for (const auto& rect : rects) results.push_back(range(rect));
+        return results;
+    }
+
+    vector<vector<int>> nearestBatch(const vector<pair<double, double>>& queries, size_t k) const {
+        vector<vector<int>> results;
+        results.reserve(queries.size());
+        for (const auto& q : queries) results.push_back(nearest(q.first, q.second, k));
+        return results;
+    }
+};
+
+// Запросы к корректному BST: порядковые статистики и агрегаты координат по диапазону ID.
+// Каждый узел дополнен агрегатом своего поддерева (размер, сумма/минимум/максимум x и y),
+// поэтому одиночный запрос проходит один-два пути от корня - O(высоты).
+class BSTQueryEngine {
+public:
+    struct Aggregate {
+        long long count = 0;
+        double sumX = 0, sumY = 0;
+        double minX = INFINITY, maxX = -INFINITY;
+        double minY = INFINITY, maxY = -INFINITY;
+
+        void add(double x, double y) {
+            count++;
+            sumX += x;
+            sumY += y;
+            minX = min(minX, x);
+            maxX = max(maxX, x);
+            minY = min(minY, y);
+            maxY = max(maxY, y);
+        }
+
+        void add(const Aggregate& other) {
+            count += other.count;
+            sumX += other.sumX;
+            sumY += other.sumY;
+            minX = min(minX, other.minX);
+            maxX = max(maxX, other.maxX);
+            minY = min(minY, other.minY);
+            maxY = max(maxY, other.maxY);
+        }
+    };
+
+private:
+    const CompactTree& tree;
+    vector<Aggregate> subtree;
+
+    uint32_t left(uint32_t node) const { return tree.nodes[node].left; }
+    uint32_t right(uint32_t node) const { return tree.nodes[node].right; }
+    int id(uint32_t node) const { return tree.nodes[node].id; }
+
+    long long size(uint32_t node) const {
+        return node == CompactTree::NIL ? 0 : subtree[node].count;
+    }
+
+    // Количество ID < key (strict) или <= key (!strict)
+    long long countBelow(long long key, bool strict) const {
+        long long count = 0;
+        uint32_t node = tree.root();
+        while (node != CompactTree::NIL) {
+            if (id(node) < key || (!strict && id(node) == key)) {
+                count += size(left(node)) + 1;
+                node = right(node);
+            } else {
+                node = left(node);
+            }
+        }
+        return count;
+    }
+
+    // Обход в порядке возрастания ID; visit возвращает false, чтобы остановиться
+    template <typename Visit>
+    void inorder(Visit visit) const {
+        vector<uint32_t> stack;
+        uint32_t node = tree.root();
+        while (node != CompactTree::NIL || !stack.empty()) {
+            while (node != CompactTree::NIL) {
+                stack.push_back(node);
+                node = left(node);
+            }
+            node = stack.back();
+            stack.pop_back();
+            if (!visit(node)) return;
+            node = right(node);
+        }
+    }
+
+public:
+    // Дерево должно быть корректным BST и жить дольше движка
+    explicit BSTQueryEngine(const CompactTree& tree) : tree(tree), subtree(tree.nodes.size()) {
+        if (!TreeAnalyzer::analyze(tree).isBST) throw invalid_argument("дерево не является корректным BST");
+        // в раскладке preorder дети всегда правее родителя, поэтому агрегаты считаются с конца
+        for (size_t i = tree.nodes.size(); i-- > 0;) {
+            const CompactNode& node = tree.nodes[i];
+            subtree[i].add(node.x, node.y);
+            if (node.left != CompactTree::NIL) subtree[i].add(subtree[node.left]);
+            if (node.right != CompactTree::NIL) subtree[i].add(subtree[node.right]);
+        }
+    }
+
+    long long size() const {
+        return size(tree.root());
+    }
+
+    // k-й по возрастанию ID (k с единицы)
+    int kth(long long k) const {
+        if (k < 1 || k > size()) throw out_of_range("k вне диапазона");
+        uint32_t node = tree.root();
+        while (true) {
+            long long leftSize = size(left(node));
+            if (k <= leftSize) {
+                node = left(node);
+            } else if (k == leftSize + 1) {
+                return id(node);
+            } else {
+                k -= leftSize + 1;
+                node = right(node);
+            }
+        }
+    }
+
+    // Сколько ID меньше id
+    long long rank(int key) const {
+        return countBelow(key, true);
+    }
+
+    // Сколько ID в [lo, hi]
+    long long countRange(int lo, int hi) const {
+        if (lo > hi) return 0;
+        return countBelow(hi, false) - countBelow(lo, true);
+    }
+
+    // Сумма/минимум/максимум координат узлов с ID в [lo, hi]
+    Aggregate aggregate(int lo, int hi) const {
+        Aggregate result;
+        uint32_t split = tree.root();
+        while (split != CompactTree::NIL && (id(split) < lo || id(split) > hi)) {
+            split = id(split) < lo ? right(split) : left(split);
+        }
+        if (split == CompactTree::NIL) return result;
+        result.add(tree.nodes[split].x, tree.nodes[split].y);
+
+        // левая граница: всё правее пути с ID >= lo целиком входит в ответ
+        for (uint32_t node = left(split); node != CompactTree::NIL;) {
+            if (id(node) >= lo) {
+                result.add(tree.nodes[node].x, tree.nodes[node].y);
+                if (right(node) != CompactTree::NIL) result.add(subtree[right(node)]);
+                node = left(node);
+            } else {
+                node = right(node);
+            }
+        }
+        // правая граница симметрично
+        for (uint32_t node = right(split); node != CompactTree::NIL;) {
+            if (id(node) <= hi) {
+                result.add(tree.nodes[node].x, tree.nodes[node].y);
+                if (left(node) != CompactTree::NIL) result.add(subtree[left(node)]);
+                node = right(node);
+            } else {
+                node = left(node);
+            }
+        }
+        return result;
+    }
+
+    // Пакетные запросы: ключи сортируются, и все ответы собираются
+    // за один обход дерева по возрастанию ID (O(n + q log q) вместо O(q * высота))
+    vector<long long> rankBatch(const vector<int>& keys) const {
+        vector<size_t> order(keys.size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+        vector<long long> result(keys.size());
+        size_t next = 0;
+        long long passed = 0;
+        inorder([&](uint32_t node) {
+            while (next < order.size() && keys[order[next]] <= id(node)) result[order[next++]] = passed;
+            passed++;
+            return next < order.size();
+        });
+        while (next < order.size()) result[order[next++]] = passed;
+        return result;
+    }
+
+    vector<int> kthBatch(const vector<long long>& ks) const {
+        for (long long k : ks) {
+            if (k < 1 || k > size()) throw out_of_range("k вне диапазона");
+        }
+        vector<size_t> order(ks.size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        sort(order.begin(), order.end(), [&](size_t a, size_t b) { return ks[a] < ks[b]; });
+
+        vector<int> result(ks.size());
+        size_t next = 0;
+        long long position = 0;
+        inorder([&](uint32_t node) {
+            position++;
+            while (next < order.size() && ks[order[next]] == position) result[order[next++]] = id(node);
+            return next < order.size();
+        });
+        return result;
+    }
+
+    // Диапазоны [lo, hi] сводятся к рангам концов, которые считаются одним обходом
+    vector<long long> countRangeBatch(const vector<pair<int, int>>& ranges) const {
+        vector<int> keys;
+        keys.reserve(2 * ranges.size());
+        for (auto [lo, hi] : ranges) {
+            keys.push_back(lo);
+            keys.push_back(hi == INT_MAX ? hi : hi + 1);
+        }
+        vector<long long> ranks = rankBatch(keys);
+
+        vector<long long> result(ranges.size());
+        for (size_t i = 0; i < ranges.size(); i++) {
+            auto [lo, hi] = ranges[i];
+            if (lo > hi) continue;
+            long long upper = hi == INT_MAX ? size() : ranks[2 * i + 1];
+            result[i] = upper - ranks[2 * i];
+        }
+        return result;
+    }
+};
+
+// Перестройка корректного BST в идеально сбалансированное за O(n):
+// узлы выписываются по возрастанию ID, затем середина каждого отрезка становится корнем поддерева
+class TreeBalancer {
+public:
+    template <typename Layout>
+    static vector<typename Layout::Ref> inorder(const Layout& layout, typename Layout::Ref root) {
+        using Ref = typename Layout::Ref;
+        vector<Ref> result, stack;
+        Ref node = root;
+        while (node != layout.null() || !stack.empty()) {
+            while (node != layout.null()) {
+                stack.push_back(node);
+                node = layout.left(node);
+            }
+            node = stack.back();
+            stack.pop_back();
+            result.push_back(node);
+            node = layout.right(node);
+        }
+        return result;
+    }
+
+    // Узлы не копируются, меняются только связи; возвращается новый корень
+    static TreeNode* rebalance(TreeNode* root) {
+        if (!TreeAnalyzer::analyze(root).isBST) throw invalid_argument("дерево не является корректным BST");
+        vector<TreeNode*> sorted = inorder(PointerLayout{}, root);
+
+        struct Range {
+            long long lo, hi;
+            TreeNode** slot;
+        };
+        TreeNode* newRoot = nullptr;
+        vector<Range> stack = {{0, (long long)sorted.size() - 1, &newRoot}};
+        while (!stack.empty()) {
+            Range r = stack.back();
+            stack.pop_back();
+            if (r.lo > r.hi) {
+                *r.slot = nullptr;
+                continue;
+            }
+            long long mid = r.lo + (r.hi - r.lo) / 2;
+            TreeNode* node = sorted[mid];
+            *r.slot = node;
+            stack.push_back({mid + 1, r.hi, &node->right});
+            stack.push_back({r.lo, mid - 1, &node->left});
+        }
+        return newRoot;
+    }
+
+    // Новое компактное дерево, снова в порядке preorder
+    static CompactTree rebalance(const CompactTree& tree) {
+        if (!TreeAnalyzer::analyze(tree).isBST) throw invalid_argument("дерево не является корректным BST");
+        vector<uint32_t> sorted = inorder(CompactLayout{tree.nodes.data()}, tree.root());
+
+        struct Range {
+            long long lo, hi;
+            uint64_t slot;
+        };
+        const uint64_t ROOT = UINT64_MAX;
+        CompactTree result;
+        result.nodes.reserve(sorted.size());
+        vector<Range> stack = {{0, (long long)sorted.size() - 1, ROOT}};
+        while (!stack.empty()) {
+            Range r = stack.back();
+            stack.pop_back();
+            if (r.lo > r.hi) continue;
+            long long mid = r.lo + (r.hi - r.lo) / 2;
+            CompactNode node = tree.nodes[sorted[mid]];
+            node.left = node.right = CompactTree::NIL;
+            uint32_t index = (uint32_t)result.nodes.size();
+            result.nodes.push_back(node);
+            if (r.slot != ROOT) {
+                CompactNode& parent = result.nodes[r.slot >> 1];
+                (r.slot & 1 ? parent.right : parent.left) = index;
+            }
+            stack.push_back({mid + 1, r.hi, uint64_t(index) * 2 + 1});
+            stack.push_back({r.lo, mid - 1, uint64_t(index) * 2});
+        }
+        return result;
+    }
+};
+
+// AVL-дерево: после каждой вставки и удаления высоты поддеревьев любого узла
+// различаются не более чем на 1, поэтому высота остаётся O(log n) при любом порядке обновлений.
+// Рекурсия здесь допустима: её глубина ограничена высотой дерева (~1.44 log2 n).
+class AVLTree {
+public:
+    struct Node {
+        int id;
+        double x, y;
+        Node* left;
+        Node* right;
+        int height;
+
+        Node(int id, double x, double y) : id(id), x(x), y(y), left(nullptr), right(nullptr), height(1) {}
+    };
+
+    struct Layout {
+        using Ref = const Node*;
+
+        Ref null() const { return nullptr; }
+        int id(Ref node) const { return node->id; }
+        Ref left(Ref node) const { return node->left; }
+        Ref right(Ref node) const { return node->right; }
+    };
+
+private:
+    Node* root;
+    size_t count;
+
+    static int height(Node* node) {
+        return node ? node->height : 0;
+    }
+
+    static void update(Node* node) {
+        node->height = 1 + max(height(node->left), height(node->right));
+    }
+
+    static Node* rotateRight(Node* node) {
+        Node* pivot = node->left;
+        node->left = pivot->right;
+        pivot->right = node;
+        update(node);
+        update(pivot);
+        return pivot;
+    }
+
+    static Node* rotateLeft(Node* node) {
+        Node* pivot = node->right;
+        node->right = pivot->left;
+        pivot->left = node;
+        update(node);
+        update(pivot);
+        return pivot;
+    }
+
+    static Node* balance(Node* node) {
+        update(node);
+        int factor = height(node->left) - height(node->right);
+        if (factor > 1) {
+            if (height(node->left->left) < height(node->left->right)) node->left = rotateLeft(node->left);
+            return rotateRight(node);
+        }
+        if (factor < -1) {
+            if (height(node->right->right) < height(node->right->left)) node->right = rotateRight(node->right);
+            return rotateLeft(node);
+        }
+        return node;
+    }
+
+    Node* insert(Node* node, int id, double x, double y, bool& inserted) {
+        if (!node) {
+            inserted = true;
+            return new Node(id, x, y);
+        }
+        if (id < node->id) {
+            node->left = insert(node->left, id, x, y, inserted);
+        } else if (id > node->id) {
+            node->right = insert(node->right, id, x, y, inserted);
+        } else {
+            node->x = x;
+            node->y = y;
+            return node;
+        }
+        return balance(node);
+    }
+
+    static Node* detachMin(Node* node, Node*& minNode) {
+        if (!node->left) {
+            minNode = node;
+            return node->right;
+        }
+        node->left = detachMin(node->left, minNode);
+        return balance(node);
+    }
+
+    Node* erase(Node* node, int id, bool& erased) {
+        if (!node) return nullptr;
+        if (id < node->id) {
+            node->left = erase(node->left, id, erased);
+        } else if (id > node->id) {
+            node->right = erase(node->right, id, erased);
+        } else {
+            erased = true;
+            Node* left = node->left;
+            Node* right = node->right;
+            delete node;
+            if (!right) return left;
+            Node* successor;
+            right = detachMin(right, successor);
+            successor->left = left;
+            successor->right = right;
+            return balance(successor);
+        }
+        return balance(node);
+    }
+
+    // Идеально сбалансированное дерево из узлов, отсортированных по ID
+    template <typename Source>
+    static Node* build(const vector<Source>& sorted, long long lo, long long hi) {
+        if (lo > hi) return nullptr;
+        long long mid = lo + (hi - lo) / 2;
+        Node* node = new Node(sorted[mid]->id, sorted[mid]->x, sorted[mid]->y);
+        node->left = build(sorted, lo, mid - 1);
+        node->right = build(sorted, mid + 1, hi);
+        update(node);
+        return node;
+    }
+
+public:
+    AVLTree() : root(nullptr), count(0) {}
+
+    AVLTree(AVLTree&& other) : root(other.root), count(other.count) {
+        other.root = nullptr;
+        other.count = 0;
+    }
+
+    AVLTree(const AVLTree&) = delete;
+    AVLTree& operator=(const AVLTree&) = delete;
+
+    ~AVLTree() {
+        vector<Node*> stack;
+        if (root) stack.push_back(root);
+        while (!stack.empty()) {
+            Node* node = stack.back();
+            stack.pop_back();
+            if (node->left) stack.push_back(node->left);
+            if (node->right) stack.push_back(node->right);
+            delete node;
+        }
+    }
+
+    // Загрузка из корректного BST за O(n) (без n вставок по O(log n))
+    static AVLTree fromTree(const CompactTree& tree) {
+        if (!TreeAnalyzer::analyze(tree).isBST) throw invalid_argument("дерево не является корректным BST");
+        vector<uint32_t> order = TreeBalancer::inorder(CompactLayout{tree.nodes.data()}, tree.root());
+        vector<const CompactNode*> sorted;
+        sorted.reserve(order.size());
+        for (uint32_t index : order) sorted.push_back(&tree.nodes[index]);
+
+        AVLTree result;
+        result.root = build(sorted, 0, (long long)sorted.size() - 1);
+        result.count = sorted.size();
+        return result;
+    }
+
+    static AVLTree fromTree(TreeNode* root) {
+        if (!TreeAnalyzer::analyze(root).isBST) throw invalid_argument("дерево не является корректным BST");
+        vector<TreeNode*> sorted = TreeBalancer::inorder(PointerLayout{}, root);
+
+        AVLTree result;
+        result.root = build(sorted, 0, (long long)sorted.size() - 1);
+        result.count = sorted.size();
+        return result;
+    }
+
+    // false, если такой ID уже был (тогда обновляются координаты)
+    bool insert(int id, double x, double y) {
+        bool inserted = false;
+        root = insert(root, id, x, y, inserted);
+        if (inserted) count++;
+        return inserted;
+    }
+
+    bool erase(int id) {
+        bool erased = false;
+        root = erase(root, id, erased);
+        if (erased) count--;
+        return erased;
+    }
+
+    bool contains(int id) const {
+        for (Node* node = root; node; node = id < node->id ? node->left : node->right) {
+            if (node->id == id) return true;
+        }
+        return false;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    int getHeight() const {
+        return height(root);
+    }
+
+    TreeStats stats(string* preorder = nullptr) const {
+        return TreeAnalyzer::analyze(Layout{}, root, preorder);
     }
 };
 
 class TreeProcessor {
     TreeNode* root;
+    CompactTree compactTree; // используется вместо root в компактном режиме
+    bool compact;
 
     void deleteTree(TreeNode* node) {
-        if (!node) return;
-        deleteTree(node->left);
-        deleteTree(node->right);
-        delete node;
+        vector<TreeNode*> stack;
+        if (node) stack.push_back(node);
+        while (!stack.empty()) {
+            TreeNode* current = stack.back();
+            stack.pop_back();
+            if (current->left) stack.push_back(current->left);
+            if (current->right) stack.push_back(current->right);
+            delete current;
+        }
     }
 
 public:
-    TreeProcessor(const string& input) : root(nullptr) {
-        vector<string> tokens;
-        stringstream ss(input);
-        string token;
-        
-        while (ss >> token) {
-            tokens.push_back(token);
-        }
-
-        int index = 0;
-        root = TreeBuilder::buildTree(tokens, index);
+    // compact = true - узлы хранятся в арене CompactTree, а не отдельными new
+    TreeProcessor(string_view input, bool compact = false) : root(nullptr), compact(compact) {
+        TreeParser parser(input);
+        if (compact) compactTree = CompactTree::parse(parser);
+        else root = TreeBuilder::buildTree(parser);
     }
 
     ~TreeProcessor() {
         deleteTree(root);
     }
-    void printNode(TreeNode* node) {
-        if (!node) {
-            cout << "#";
-            return;
-        }
-        cout << node->id;
+
+    TreeNode* getRoot() const {
+        return root;
     }
-    void printPreorder(TreeNode* node) {
-        if (!node) {
-            cout << "#" << " ";
+
+    const CompactTree& getCompactTree() const {
+        return compactTree;
+    }
+
+    // Перестраивает корректное BST в идеально сбалансированное, иначе бросает invalid_argument
+    void rebalance() {
+        if (compact) compactTree = TreeBalancer::rebalance(compactTree);
+        else root = TreeBalancer::rebalance(root);
+    }
+
+    void analyze() {
+        if (compact ? compactTree.empty() : !root) {
+            printStats(TreeStats(), nullptr);
             return;
         }
-        cout << node->id << " ";
-        printPreorder(node->left);
-        printPreorder(node->right);
+
+        string preorder;
+        TreeStats stats = compact ? TreeAnalyzer::analyze(compactTree, &preorder)
+                                  : TreeAnalyzer::analyze(root, &preorder);
+        printStats(stats, &preorder);
     }
 
-    void analyze() {
-        if (!root) {
+    // preorder = nullptr - структура дерева не выводится
+    static void printStats(const TreeStats& stats, const string* preorder) {
+        if (stats.nodes == 0) {
             cout << "Общее количество узлов: 0\nМинимальный ID: 0\nМаксимальный ID: 0\n"
-                 << "Высота дерева: 0\nКоличество листьев: 0\n";
+                 << "Высота дерева: 0\nКоличество листьев: 0\nКорректное BST: да\n";
             return;
         }
 
-
-        cout << "Общее количество узлов: " << TreeAnalyzer::countNodes(root) << "\n"
-             << "Минимальный ID: " << TreeAnalyzer::findMinID(root) << "\n"
-             << "Максимальный ID: " << TreeAnalyzer::findMaxID(root) << "\n"
-             << "Высота дерева: " << TreeAnalyzer::getHeight(root) << "\n"
-             << "Количество листьев: " << TreeAnalyzer::countLeaves(root) << "\n";
+        cout << "Общее количество узлов: " << stats.nodes << "\n"
+             << "Минимальный ID: " << stats.minID << "\n"
+             << "Максимальный ID: " << stats.maxID << "\n"
+             << "Высота дерева: " << stats.height << "\n"
+             << "Количество листьев: " << stats.leaves << "\n"
+             << "Корректное BST: " << (stats.isBST ? "да" : "нет") << "\n";
+        if (!preorder) return;
         cout << "Структура дерева (preorder): ";
-        printPreorder(root);
+        cout.write(preorder->data(), preorder->size());
         cout << "\n";
     }
 };
 
-class TestGenerator {
-    static void buildPreorder(const vector<int>& ids, int start, int end, vector<string>& preorder) {
-        if (start > end) {
-            preorder.push_back("#");
-            return;
+// Потоковый генератор входных деревьев: токены сразу уходят в приёмник (строку или FILE*),
+// дополнительная память - только стек отрезков глубиной порядка высоты дерева.
+// ID узлов - 10, 20, ..., 10n; координаты узла с ID = k - (k * 0.1, k * 0.2).
+class TreeGenerator {
+public:
+    enum class Shape { Balanced, Skewed, Random, Invalid };
+
+    struct StringSink {
+        string& out;
+
+        void write(const char* data, size_t size) {
+            out.append(data, size);
         }
+    };
 
-        int mid = (start + end) / 2;
-        preorder.push_back(to_string(ids[mid]));
-        preorder.push_back(to_string(ids[mid] * 0.1));
-        preorder.push_back(to_string(ids[mid] * 0.2));
+    // Буферизованная запись в файл или конвейер; fwrite вызывается блоками по capacity байт
+    class FileSink {
+        FILE* file;
+        vector<char> buffer;
+        size_t used = 0;
 
-        buildPreorder(ids, start, mid - 1, preorder);
-        buildPreorder(ids, mid + 1, end, preorder);
-    }
+    public:
+        explicit FileSink(FILE* file, size_t capacity = 1 << 20) : file(file), buffer(capacity) {}
 
-public:
-    static string generateValidBST(int n) {
-        if (n == 0) return "#";
-        
-        vector<int> ids;
-        for (int i = 1; i <= n; i++) ids.push_back(i * 10);
-        
-        vector<string> preorder;
-        buildPreorder(ids, 0, ids.size() - 1, preorder);
-        
-        string result;
-        for (const auto& token : preorder) {
-            if (!result.empty()) result += " ";
-            result += token;
+        void write(const char* data, size_t size) {
+            if (used + size > buffer.size()) flush();
+            memcpy(buffer.data() + used, data, size);
+            used += size;
         }
-        return result;
+
+        void flush() {
+            if (used > 0 && fwrite(buffer.data(), 1, used, file) != used) {
+                throw runtime_error("ошибка записи сгенерированного дерева");
+            }
+            used = 0;
+        }
+    };
+
+    static bool parseShape(const string& name, Shape& shape) {
+        if (name == "balanced") shape = Shape::Balanced;
+        else if (name == "skewed") shape = Shape::Skewed;
+        else if (name == "random") shape = Shape::Random;
+        else if (name == "invalid") shape = Shape::Invalid;
+        else return false;
+        return true;
     }
 
-    static string generateInvalidBST(int n) {
-        string valid = generateValidBST(n);
-        vector<string> tokens;
-        stringstream ss(valid);
-        string token;
-        
-        while (ss >> token) tokens.push_back(token);
+    // Balanced - середина каждого отрезка ID становится корнем поддерева;
+    // Skewed - цепочка вправо; Random - корень отрезка выбирается случайно (как BST
+    // после вставки в случайном порядке); Invalid - Balanced, где ID корня и максимальный ID
+    // поменяны местами. Случайный выбор сделан без uniform_int_distribution, чтобы при одном seed
+    // деревья совпадали и в MSVC, и в GCC.
+    template <typename Sink>
+    static void generate(Sink& sink, Shape shape, int n, uint64_t seed = 1) {
+        if (n < 0 || (long long)n * 10 > INT_MAX) throw invalid_argument("недопустимое число узлов");
 
-        if (tokens.size() < 6) return valid;
+        if (shape == Shape::Skewed) {
+            for (int i = 1; i <= n; i++) {
+                writeNode(sink, i * 10, i * 10);
+                sink.write("# ", 2);
+            }
+            sink.write("#\n", 2);
+            return;
+        }
 
-        vector<int> nodeIndices;
-        for (int i = 0; i < tokens.size(); i += 3) {
-            if (tokens[i] != "#") nodeIndices.push_back(i);
+        const int rootId = (1 + (n - 1) / 2) * 10;
+        const int maxId = n * 10;
+        mt19937_64 rng(seed);
+        vector<pair<int, int>> ranges = {{1, n}};
+        while (!ranges.empty()) {
+            auto [start, end] = ranges.back();
+            ranges.pop_back();
+            if (start > end) {
+                sink.write("# ", 2);
+                continue;
+            }
+            int mid = shape == Shape::Random ? start + (int)(rng() % (uint64_t)(end - start + 1))
+                                             : start + (end - start) / 2;
+            int id = mid * 10;
+            if (shape == Shape::Invalid) {
+                if (id == rootId) id = maxId;
+                else if (id == maxId) id = rootId;
+            }
+            writeNode(sink, id, mid * 10);
+            ranges.push_back({mid + 1, end});
+            ranges.push_back({start, mid - 1});
         }
+        sink.write("\n", 1);
+    }
 
-        if (nodeIndices.size() < 2) return valid;
+    static string generate(Shape shape, int n, uint64_t seed = 1) {
+        string out;
+        StringSink sink{out};
+        generate(sink, shape, n, seed);
+        return out;
+    }
 
-        swap(tokens[nodeIndices[0]], tokens[nodeIndices.back()]);
-        
-        string result;
-        for (const auto& t : tokens) {
-            if (!result.empty()) result += " ";
-            result += t;
+    // path == "-" - запись в стандартный вывод
+    static void generateToFile(const string& path, Shape shape, int n, uint64_t seed) {
+        FILE* file = path == "-" ? stdout : fopen(path.c_str(), "wb");
+        if (!file) throw runtime_error("не удалось открыть файл " + path);
+        try {
+            FileSink sink(file);
+            generate(sink, shape, n, seed);
+            sink.flush();
+        } catch (...) {
+            if (file != stdout) fclose(file);
+            throw;
         }
-        return result;
+        if (file == stdout ? fflush(file) != 0 : fclose(file) != 0) {
+            throw runtime_error("ошибка записи в файл " + path);
+        }
+    }
+
+private:
+    template <typename Sink>
+    static void writeNode(Sink& sink, int id, int coordBase) {
+        char buffer[64];
+        char* end = buffer + sizeof(buffer);
+        char* p = to_chars(buffer, end, id).ptr;
+        *p++ = ' ';
+        p = to_chars(p, end, coordBase * 0.1).ptr;
+        *p++ = ' ';
+        p = to_chars(p, end, coordBase * 0.2).ptr;
+        *p++ = ' ';
+        sink.write(buffer, p - buffer);
+    }
+};
+
+class TestGenerator {
+public:
+    static string generateValidBST(int n) {
+        return TreeGenerator::generate(TreeGenerator::Shape::Balanced, n);
+    }
+
+    static string generateInvalidBST(int n) {
+        return TreeGenerator::generate(TreeGenerator::Shape::Invalid, n);
     }
 };
 
@@ -251,7 +1749,311 @@ void runTests() {
     cout << "ЕСТЫ ЗАВЕРШЕНЫ\n";
 }
 
-int main() {
+// Замеры на больших деревьях: сбалансированном и вырожденном (цепочка вправо)
+class TreeBenchmark {
+    template <typename Func>
+    static double measure(Func func) {
+        auto start = chrono::steady_clock::now();
+        func();
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+
+public:
+    static string balancedInput(int n) {
+        return TreeGenerator::generate(TreeGenerator::Shape::Balanced, n);
+    }
+
+    static string skewedInput(int n) {
+        return TreeGenerator::generate(TreeGenerator::Shape::Skewed, n);
+    }
+
+    static void run(int n) {
+        cout << "Замеры для деревьев из " << n << " узлов\n";
+        vector<pair<string, string>> inputs;
+        inputs.push_back({"сбалансированное", balancedInput(n)});
+        inputs.push_back({"вырожденное", skewedInput(n)});
+
+        for (auto& [name, input] : inputs) {
+            TreeProcessor* processor = nullptr;
+            int nodes = 0, height = 0, leaves = 0;
+            bool valid = false;
+
+            double parseMs = measure([&]() { processor = new TreeProcessor(input); });
+            TreeNode* root = processor->getRoot();
+            double countMs = measure([&]() { nodes = TreeAnalyzer::countNodes(root); });
+            double heightMs = measure([&]() { height = TreeAnalyzer::getHeight(root); });
+            double leavesMs = measure([&]() { leaves = TreeAnalyzer::countLeaves(root); });
+            double bstMs = measure([&]() { valid = TreeAnalyzer::isValidBST(root); });
+            double fusedMs = measure([&]() { TreeAnalyzer::analyze(root); });
+            double deleteMs = measure([&]() { delete processor; });
+
+            TreeProcessor* compactProcessor = nullptr;
+            double compactParseMs = measure([&]() { compactProcessor = new TreeProcessor(input, true); });
+            const CompactTree& compactTree = compactProcessor->getCompactTree();
+            double compactMs = measure([&]() { TreeAnalyzer::analyze(compactTree); });
+            size_t compactBytes = compactTree.memoryBytes();
+            double compactDeleteMs = measure([&]() { delete compactProcessor; });
+
+            cout << "\nДерево: " << name << " (узлов " << nodes << ", высота " << height
+                 << ", листьев " << leaves << ", BST: " << (valid ? "да" : "нет") << ")\n"
+                 << "  разбор:             " << parseMs << " мс\n"
+                 << "  countNodes:         " << countMs << " мс\n"
+                 << "  getHeight:          " << heightMs << " мс\n"
+                 << "  countLeaves:        " << leavesMs << " мс\n"
+                 << "  isValidBST:         " << bstMs << " мс\n"
+                 << "  analyze (всё сразу):" << fusedMs << " мс\n"
+                 << "  удаление:           " << deleteMs << " мс\n"
+                 << "  память узлов:       " << nodes * sizeof(TreeNode) / (1024.0 * 1024.0)
+                 << " МБ (" << sizeof(TreeNode) << " байт на узел + служебные данные new)\n"
+                 << "Компактная раскладка (арена, 32-битные индексы):\n"
+                 << "  разбор:             " << compactParseMs << " мс\n"
+                 << "  analyze:            " << compactMs << " мс\n"
+                 << "  удаление:           " << compactDeleteMs << " мс\n"
+                 << "  память узлов:       " << compactBytes / (1024.0 * 1024.0)
+                 << " МБ (" << sizeof(CompactNode) << " байт на узел)\n";
+        }
+    }
+
+    // Ускорение параллельного анализа на сбалансированном компактном дереве для 1..maxThreads потоков
+    static void runParallel(int n, unsigned maxThreads) {
+        cout << "Параллельный анализ, сбалансированное дерево из " << n << " узлов\n";
+        CompactTree tree;
+        {
+            string input = balancedInput(n);
+            TreeParser parser(input);
+            tree = CompactTree::parse(parser);
+        }
+
+        TreeStats reference;
+        double sequentialMs = measure([&]() { reference = TreeAnalyzer::analyze(tree); });
+        cout << "  последовательно:   " << fixed << setprecision(2) << sequentialMs << " мс\n";
+
+        for (unsigned threads = 1; threads <= maxThreads; threads++) {
+            WorkStealingPool pool(threads);
+            TreeStats stats;
+            double ms = measure([&]() { stats = ParallelTreeAnalyzer::analyze(tree, pool); });
+            bool same = stats.nodes == reference.nodes && stats.height == reference.height &&
+                        stats.leaves == reference.leaves && stats.minID == reference.minID &&
+                        stats.maxID == reference.maxID && stats.isBST == reference.isBST;
+            cout << "  потоков " << setw(2) << threads << ":        " << ms << " мс, ускорение "
+                 << sequentialMs / ms << (same ? "" : "  ОШИБКА: результат отличается") << "\n";
+        }
+        cout.unsetf(ios::fixed);
+    }
+};
+
+int main(int argc, char* argv[]) {
+    // lab1 --file <путь> [--compact] [--balance] - дерево читается из файла, отображённого в память;
+    // --compact хранит узлы в арене с 32-битными индексами,
+    // --balance перед анализом перестраивает корректное BST в сбалансированное
+    if (argc >= 3 && string(argv[1]) == "--file") {
+        bool compact = false, balance = false;
+        for (int i = 3; i < argc; i++) {
+            string option = argv[i];
+            if (option == "--compact") compact = true;
+            else if (option == "--balance") balance = true;
+            else {
+                cout << "неизвестный параметр: " << option << "\n";
+                return 1;
+            }
+        }
+        try {
+            MappedFile file(argv[2]);
+            TreeProcessor processor(file.view(), compact);
+            if (balance) processor.rebalance();
+            processor.analyze();
+        } catch (const exception& e) {
+            cout << "ошибка: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // lab1 --to-binary <текст> <файл.bin> - перевод текстового preorder в двоичный формат
+    if (argc == 4 && string(argv[1]) == "--to-binary") {
+        try {
+            MappedFile file(argv[2]);
+            TreeParser parser(file.view());
+            BinaryTreeWriter::write(CompactTree::parse(parser), argv[3]);
+        } catch (const exception& e) {
+            cout << "ошибка: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // lab1 --binary <файл.bin> [--stats] - анализ дерева прямо из отображённого двоичного файла;
+    // --stats не выводит структуру дерева
+    if ((argc == 3 || argc == 4) && string(argv[1]) == "--binary") {
+        try {
+            MappedFile file(argv[2]);
+            BinaryTreeView tree(file.view());
+            string preorder;
+            bool withStructure = !(argc == 4 && string(argv[3]) == "--stats");
+            TreeStats stats = TreeAnalyzer::analyze(tree, withStructure ? &preorder : nullptr);
+            TreeProcessor::printStats(stats, withStructure ? &preorder : nullptr);
+        } catch (const exception& e) {
+            cout << "ошибка: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // lab1 --query <дерево> <запросы> - запросы к корректному BST, по одному в строке:
+    //   kth k | rank id | count lo hi | agg lo hi
+    if (argc == 4 && string(argv[1]) == "--query") {
+        try {
+            MappedFile file(argv[2]);
+            TreeParser parser(file.view());
+            CompactTree tree = CompactTree::parse(parser);
+            BSTQueryEngine engine(tree);
+
+            ifstream queries(argv[3]);
+            if (!queries) throw runtime_error(string("не удалось открыть файл ") + argv[3]);
+            string kind;
+            while (queries >> kind) {
+                if (kind == "kth") {
+                    long long k;
+                    queries >> k;
+                    cout << engine.kth(k) << "\n";
+                } else if (kind == "rank") {
+                    int key;
+                    queries >> key;
+                    cout << engine.rank(key) << "\n";
+                } else if (kind == "count") {
+                    int lo, hi;
+                    queries >> lo >> hi;
+                    cout << engine.countRange(lo, hi) << "\n";
+                } else if (kind == "agg") {
+                    int lo, hi;
+                    queries >> lo >> hi;
+                    auto agg = engine.aggregate(lo, hi);
+                    cout << agg.count;
+                    if (agg.count > 0) {
+                        cout << " sumX " << agg.sumX << " sumY " << agg.sumY
+                             << " x [" << agg.minX << ", " << agg.maxX << "]"
+                             << " y [" << agg.minY << ", " << agg.maxY << "]";
+                    }
+                    cout << "\n";
+                } else {
+                    throw runtime_error("неизвестный запрос: " + kind);
+                }
+            }
+        } catch (const exception& e) {
+            cout << "ошибка: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // lab1 --avl <дерево> <обновления> - корректное BST загружается в AVL-дерево, затем применяются
+    // строки "insert id x y" и "erase id"; в конце выводится статистика дерева
+    if (argc == 4 && string(argv[1]) == "--avl") {
+        try {
+            MappedFile file(argv[2]);
+            TreeParser parser(file.view());
+            AVLTree tree = AVLTree::fromTree(CompactTree::parse(parser));
+
+            ifstream updates(argv[3]);
+            if (!updates) throw runtime_error(string("не удалось открыть файл ") + argv[3]);
+            string kind;
+            while (updates >> kind) {
+                if (kind == "insert") {
+                    int id;
+                    double x, y;
+                    updates >> id >> x >> y;
+                    tree.insert(id, x, y);
+                } else if (kind == "erase") {
+                    int id;
+                    updates >> id;
+                    tree.erase(id);
+                } else {
+                    throw runtime_error("неизвестное обновление: " + kind);
+                }
+            }
+            TreeProcessor::printStats(tree.stats(), nullptr);
+        } catch (const exception& e) {
+            cout << "ошибка: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // lab1 --spatial <дерево> <запросы> - запросы по координатам узлов, по одному в строке:
+    //   range minX minY maxX maxY  - ID узлов в прямоугольнике
+    //   knn x y k                  - ID k ближайших узлов
+    if (argc == 4 && string(argv[1]) == "--spatial") {
+        try {
+            MappedFile file(argv[2]);
+            TreeParser parser(file.view());
+            SpatialIndex index = SpatialIndex::fromTree(CompactTree::parse(parser));
+
+            ifstream queries(argv[3]);
+            if (!queries) throw runtime_error(string("не удалось открыть файл ") + argv[3]);
+            string kind;
+            while (queries >> kind) {
+                vector<int> ids;
+                if (kind == "range") {
+                    SpatialIndex::Rect rect;
+                    queries >> rect.minX >> rect.minY >> rect.maxX >> rect.maxY;
+                    ids = index.range(rect);
+                    sort(ids.begin(), ids.end());
+                } else if (kind == "knn") {
+                    double x, y;
+                    size_t k;
+                    queries >> x >> y >> k;
+                    ids = index.nearest(x, y, k);
+                } else {
+                    throw runtime_error("неизвестный запрос: " + kind);
+                }
+                for (size_t i = 0; i < ids.size(); i++) cout << (i ? " " : "") << ids[i];
+                cout << "\n";
+            }
+        } catch (const exception& e) {
+            cout << "ошибка: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // lab1 --generate <balanced|skewed|random|invalid> <n> [seed] [файл|-] - потоковая генерация
+    // входного дерева; по умолчанию seed = 1 и вывод в стандартный поток
+    if ((argc >= 4 && argc <= 6) && string(argv[1]) == "--generate") {
+        TreeGenerator::Shape shape;
+        if (!TreeGenerator::parseShape(argv[2], shape)) {
+            cout << "неизвестная форма дерева: " << argv[2] << "\n";
+            return 1;
+        }
+        try {
+            int n = stoi(argv[3]);
+            uint64_t seed = argc >= 5 ? stoull(argv[4]) : 1;
+            string path = argc == 6 ? argv[5] : "-";
+            auto start = chrono::steady_clock::now();
+            TreeGenerator::generateToFile(path, shape, n, seed);
+            if (path != "-") {
+                cout << "Записано узлов: " << n << " в " << path << " за "
+                     << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << " мс\n";
+            }
+        } catch (const exception& e) {
+            cout << "ошибка: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // lab1 --bench [n] - замеры на сбалансированном и вырожденном дереве
+    if (argc >= 2 && string(argv[1]) == "--bench") {
+        TreeBenchmark::run(argc >= 3 ? stoi(argv[2]) : 10000000);
+        return 0;
+    }
+
+    // lab1 --parallel-bench [n] [потоков] - ускорение параллельного анализа
+    if (argc >= 2 && string(argv[1]) == "--parallel-bench") {
+        unsigned threads = argc >= 4 ? (unsigned)stoi(argv[3]) : max(1u, thread::hardware_concurrency());
+        TreeBenchmark::runParallel(argc >= 3 ? stoi(argv[2]) : 10000000, threads);
+        return 0;
+    }
+
     string input;
     if (getline(cin, input) && input.empty()) {
     runTests();
@@ -6,6 +6,15 @@
 #include <sstream>
 #include <climits>
 #include <exception>
+#include <unordered_set>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <memory>
+#include <iomanip>
 using namespace std;
 
 template <typename T>
@@ -18,12 +27,9 @@ struct Node {
     Node(T val) : value(val), lnode(nullptr), rnode(nullptr), next(nullptr) {}
 };
 
-// Кастомная хеш-функция для любого типа T
-template <typename T>
-uint32_t custom_hash(const T& element) {
-    const uint8_t* data = reinterpret_cast<const uint8_t*>(&element);
+// Хеш произвольного блока байт
+inline uint32_t hash_bytes(const uint8_t* data, size_t size) {
     uint32_t hash = 0;
-    constexpr size_t size = sizeof(T);
 
     for (size_t i = 0; i < size; ++i) {
         hash ^= data[i];
@@ -33,6 +39,18 @@ uint32_t custom_hash(const T& element) {
     return hash;
 }
 
+// Кастомная хеш-функция для любого типа T
+template <typename T>
+uint32_t custom_hash(const T& element) {
+    return hash_bytes(reinterpret_cast<const uint8_t*>(&element), sizeof(T));
+}
+
+// Для строки хешируются её символы: в байтах самого объекта лежит указатель на буфер,
+// и у равных строк он разный
+inline uint32_t custom_hash(const std::string& element) {
+    return hash_bytes(reinterpret_cast<const uint8_t*>(element.data()), element.size());
+}
+
 template <typename T>
 struct LinkedHashSet {
 private:
@@ -132,10 +150,11 @@ public:
         }
 
         // Удаляем из связанного списка
+        Node<T>* prev_in_list = nullptr;
         if (current == head) {
             head = head->next;
         } else {
-            Node<T>* prev_in_list = head;
+            prev_in_list = head;
             while (prev_in_list != nullptr && prev_in_list->next != current) {
                 prev_in_list = prev_in_list->next;
             }
@@ -144,8 +163,9 @@ public:
             }
         }
 
+        // Новый хвост - предыдущий элемент в порядке вставки, а не в бакете
         if (current == tail) {
-            tail = (current == head) ? nullptr : prev_in_bucket;
+            tail = prev_in_list;
         }
 
         delete current;
@@ -180,7 +200,307 @@ public:
     }
 };
 
-int main() {
+// ======================= Бенчмарк =======================
+
+// Подсчёт занятой кучи для оценки памяти на элемент: перед каждым блоком хранится его размер.
+// Заголовок в 16 байт сохраняет выравнивание malloc и одинаково влияет на все реализации.
+static size_t live_heap_bytes = 0;
+
+void* operator new(size_t size) {
+    void* block = malloc(size + 16);
+    if (block == nullptr) throw bad_alloc();
+    *static_cast<size_t*>(block) = size;
+    live_heap_bytes += size;
+    return static_cast<char*>(block) + 16;
+}
+
+// GCC, встроив эту функцию, ошибочно предупреждает о free для памяти из operator new
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void operator delete(void* ptr) noexcept {
+    if (ptr == nullptr) return;
+    char* block = static_cast<char*>(ptr) - 16;
+    live_heap_bytes -= *reinterpret_cast<size_t*>(block);
+    free(block);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+// Адаптеры дают всем реализациям общий интерфейс. Чтобы сравнить ещё одну структуру,
+// достаточно написать адаптер с теми же членами и добавить его в bench_key_type.
+// MAX_SIZE - наибольший размер, на котором реализация прогоняется за разумное время.
+template <typename T>
+struct LinkedHashSetAdapter {
+    static constexpr const char* NAME = "LinkedHashSet";
+    // Таблица не растёт (16 бакетов), а удаление ищет предыдущий элемент списка за O(n)
+    static constexpr size_t MAX_SIZE = 20000;
+
+    LinkedHashSet<T> set;
+
+    void insert(const T& key) { set.insert(key); }
+    void erase(const T& key) { set.remove(key); }
+    bool contains(const T& key) const { return set.contains(key); }
+};
+
+template <typename T>
+struct UnorderedSetAdapter {
+    static constexpr const char* NAME = "std::unordered_set";
+    static constexpr size_t MAX_SIZE = SIZE_MAX;
+
+    std::unordered_set<T> set;
+
+    void insert(const T& key) { set.insert(key); }
+    void erase(const T& key) { set.erase(key); }
+    bool contains(const T& key) const { return set.count(key) != 0; }
+};
+
+// i-й ключ бенчмарка; индексы перемешиваются биективно, поэтому разные индексы дают разные ключи
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+template <typename T>
+struct BenchKey;
+
+template <>
+struct BenchKey<int> {
+    static constexpr const char* NAME = "int";
+    static int make(uint64_t i) { return static_cast<int>(static_cast<uint32_t>(i * 2654435761u)); }
+};
+
+template <>
+struct BenchKey<int64_t> {
+    static constexpr const char* NAME = "int64";
+    static int64_t make(uint64_t i) { return static_cast<int64_t>(splitmix64(i)); }
+};
+
+// Строки длиннее буфера SSO, чтобы каждая хранила символы в куче
+template <>
+struct BenchKey<string> {
+    static constexpr const char* NAME = "string";
+    static string make(uint64_t i) { return "key:" + to_string(splitmix64(i)); }
+};
+
+// Распределение Ципфа (theta = 0.99) по рангам 0..n-1 методом Грея и др. (как в YCSB):
+// после подсчёта дзета-функции за O(n) каждое значение выдаётся за O(1)
+class ZipfGenerator {
+    uint64_t n;
+    double theta, alpha, zetan, eta;
+
+public:
+    explicit ZipfGenerator(uint64_t n, double theta = 0.99) : n(n), theta(theta) {
+        zetan = 0;
+        for (uint64_t i = 1; i <= n; ++i) zetan += 1.0 / pow(double(i), theta);
+        double zeta2 = 1.0 + 1.0 / pow(2.0, theta);
+        alpha = 1.0 / (1.0 - theta);
+        eta = (1.0 - pow(2.0 / double(n), 1.0 - theta)) / (1.0 - zeta2 / zetan);
+    }
+
+    uint64_t next(mt19937_64& rng) const {
+        double u = (rng() >> 11) * (1.0 / 9007199254740992.0);
+        double uz = u * zetan;
+        if (uz < 1.0) return 0;
+        if (uz < 1.0 + pow(0.5, theta)) return 1;
+        return min(n - 1, static_cast<uint64_t>(double(n) * pow(eta * u - eta + 1.0, alpha)));
+    }
+};
+
+// Индексы ключей для одного распределения. Во множестве лежат ключи 0..n-1:
+// hit - индексы из [0, n), miss - из [n, 2n), mix - из [0, 2n) с признаком вставки/удаления
+struct Workload {
+    string distribution;
+    vector<uint64_t> hit, miss, mix;
+    vector<uint8_t> mix_insert;
+};
+
+Workload make_workload(bool zipf, uint64_t n, size_t ops, uint64_t seed) {
+    Workload w;
+    w.distribution = zipf ? "Zipf" : "равномерно";
+    mt19937_64 rng(seed);
+    unique_ptr<ZipfGenerator> zipf_n, zipf_2n;
+    if (zipf) {
+        zipf_n.reset(new ZipfGenerator(n));
+        zipf_2n.reset(new ZipfGenerator(2 * n));
+    }
+    auto pick = [&](uint64_t range, const ZipfGenerator* z) { return z ? z->next(rng) : rng() % range; };
+
+    for (size_t i = 0; i < ops; ++i) {
+        w.hit.push_back(pick(n, zipf_n.get()));
+        w.miss.push_back(n + pick(n, zipf_n.get()));
+        w.mix.push_back(pick(2 * n, zipf_2n.get()));
+        w.mix_insert.push_back(rng() & 1);
+    }
+    return w;
+}
+
+struct Measurement {
+    double ns_per_op;
+    double p99_ns;
+};
+
+// Время всей серии делится на число операций; каждая 32-я операция дополнительно
+// замеряется отдельно для p99 (из неё вычитаются накладные расходы самого таймера)
+class LatencyRecorder {
+    using Clock = chrono::steady_clock;
+
+    vector<double> samples;
+    double total_ns = 0;
+    size_t ops = 0;
+
+    static double timer_overhead_ns() {
+        static double overhead = [] {
+            vector<double> empty;
+            for (int i = 0; i < 1000; ++i) {
+                auto start = Clock::now();
+                empty.push_back(chrono::duration<double, nano>(Clock::now() - start).count());
+            }
+            nth_element(empty.begin(), empty.begin() + empty.size() / 2, empty.end());
+            return empty[empty.size() / 2];
+        }();
+        return overhead;
+    }
+
+public:
+    template <typename Op>
+    void run(size_t count, Op op) {
+        double overhead = timer_overhead_ns();
+        auto start = Clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            if ((i & 31) == 0) {
+                auto op_start = Clock::now();
+                op(i);
+                double ns = chrono::duration<double, nano>(Clock::now() - op_start).count();
+                samples.push_back(max(0.0, ns - overhead));
+            } else {
+                op(i);
+            }
+        }
+        total_ns += chrono::duration<double, nano>(Clock::now() - start).count();
+        ops += count;
+    }
+
+    Measurement result() {
+        if (ops == 0) return {0, 0};
+        size_t k = samples.size() * 99 / 100;
+        nth_element(samples.begin(), samples.begin() + k, samples.end());
+        return {total_ns / ops, samples[k]};
+    }
+};
+
+// Выравнивание по числу символов, а не байт (в UTF-8 кириллица занимает по два байта)
+string pad_right(const string& s, size_t width) {
+    size_t chars = 0;
+    for (unsigned char c : s) {
+        if ((c & 0xC0) != 0x80) ++chars;
+    }
+    return chars >= width ? s : s + string(width - chars, ' ');
+}
+
+void print_row(const string& name, Measurement m, bool ok = true) {
+    cout << "    " << pad_right(name, 34) << fixed << setprecision(1) << setw(10) << m.ns_per_op << " нс/оп"
+         << "   p99 " << setw(8) << setprecision(0) << m.p99_ns << " нс" << (ok ? "" : "   ОШИБКА") << endl;
+    cout.unsetf(ios::fixed);
+}
+
+template <typename T>
+vector<T> make_keys(const vector<uint64_t>& indices) {
+    vector<T> keys;
+    keys.reserve(indices.size());
+    for (uint64_t i : indices) keys.push_back(BenchKey<T>::make(i));
+    return keys;
+}
+
+template <typename Set, typename T>
+void bench_backend(uint64_t n, const vector<Workload>& workloads) {
+    if (n > Set::MAX_SIZE) {
+        cout << "  " << Set::NAME << ": пропущено (размер больше " << Set::MAX_SIZE << ")" << endl;
+        return;
+    }
+
+    size_t heap_before = live_heap_bytes;
+    Set* set = new Set();
+
+    // Ключи для вставки готовятся порциями вне замера, чтобы при n = 10^8 не держать их все сразу
+    const uint64_t CHUNK = 1 << 16;
+    LatencyRecorder build;
+    vector<T> chunk;
+    for (uint64_t from = 0; from < n; from += CHUNK) {
+        chunk.clear();
+        for (uint64_t i = from; i < min(n, from + CHUNK); ++i) chunk.push_back(BenchKey<T>::make(i));
+        build.run(chunk.size(), [&](size_t i) { set->insert(chunk[i]); });
+    }
+    vector<T>().swap(chunk);
+    double bytes = double(live_heap_bytes - heap_before) / double(n);
+
+    cout << "  " << Set::NAME << ", память " << fixed << setprecision(1) << bytes << " байт/элемент" << endl;
+    cout.unsetf(ios::fixed);
+    print_row("вставка " + to_string(n) + " ключей", build.result());
+
+    for (const Workload& w : workloads) {
+        vector<T> hit = make_keys<T>(w.hit), miss = make_keys<T>(w.miss), mix = make_keys<T>(w.mix);
+        size_t found = 0;
+
+        LatencyRecorder hits;
+        hits.run(hit.size(), [&](size_t i) { found += set->contains(hit[i]); });
+        print_row("поиск (есть), " + w.distribution, hits.result(), found == hit.size());
+
+        found = 0;
+        LatencyRecorder misses;
+        misses.run(miss.size(), [&](size_t i) { found += set->contains(miss[i]); });
+        print_row("поиск (нет), " + w.distribution, misses.result(), found == 0);
+
+        // Вставки и удаления идут вперемешку, размер множества держится около n
+        LatencyRecorder updates;
+        updates.run(mix.size(), [&](size_t i) {
+            if (w.mix_insert[i]) set->insert(mix[i]);
+            else set->erase(mix[i]);
+        });
+        print_row("вставка/удаление 50/50, " + w.distribution, updates.result());
+
+        // Возвращаем исходное содержимое, чтобы следующее распределение работало с теми же ключами
+        for (size_t i = 0; i < mix.size(); ++i) {
+            if (w.mix[i] < n) set->insert(mix[i]);
+            else set->erase(mix[i]);
+        }
+    }
+    delete set;
+}
+
+template <typename T>
+void bench_key_type(uint64_t n, const vector<Workload>& workloads) {
+    cout << "Ключи " << BenchKey<T>::NAME << ", n = " << n << endl;
+    bench_backend<LinkedHashSetAdapter<T>, T>(n, workloads);
+    bench_backend<UnorderedSetAdapter<T>, T>(n, workloads);
+    cout << endl;
+}
+
+// Размеры 10^3, 10^4, ... до max_size включительно; ops операций на каждую нагрузку
+void run_benchmark(uint64_t max_size, size_t ops) {
+    for (uint64_t n = 1000; n <= max_size; n *= 10) {
+        vector<Workload> workloads = {make_workload(false, n, ops, n), make_workload(true, n, ops, n + 1)};
+        bench_key_type<int>(n, workloads);
+        bench_key_type<int64_t>(n, workloads);
+        bench_key_type<string>(n, workloads);
+    }
+}
+
+// lab2                     - пример работы с LinkedHashSet
+// lab2 --bench [n] [ops]   - сравнение с std::unordered_set на размерах 10^3..n
+//                            (по умолчанию 10^6, до 10^8) по ops операций на нагрузку
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && string(argv[1]) == "--bench") {
+        uint64_t max_size = argc >= 3 ? stoull(argv[2]) : 1000000;
+        size_t ops = argc >= 4 ? stoull(argv[3]) : 200000;
+        run_benchmark(max_size, ops);
+        return 0;
+    }
+
     LinkedHashSet<int> set;
     
     set.insert(10);
@@ -4,25 +4,64 @@
 #include <algorithm>
 #include <climits>
 #include <fstream>
+#include <random>
+#include <chrono>
+#include <string>
+#include <charconv>
+#include <cstdio>
+#include <iomanip>
+#include <stdexcept>
+#include <limits>
+#include <type_traits>
 
 using namespace std;
 
+// Cap - целочисленный тип пропускных способностей и потоков; по умолчанию 64-битный,
+// чтобы ёмкости порядка миллиардов и их суммы не переполнялись
+template <typename Cap = long long>
 class FordFulkerson {
+    static_assert(is_integral<Cap>::value, "ёмкости должны быть целыми");
+
 private:
     int V; // количество вершин
-    vector<vector<int>> capacity; // матрица ёмкостей
-    vector<vector<int>> flow;     
+    vector<vector<Cap>> capacity; // матрица ёмкостей
+    vector<vector<Cap>> flow;     
     vector<int> parent;           
+    int lastIterations = 0;
+    bool verbose = true;
+    bool scaling = false;
 
 public:
-    FordFulkerson(int vertices) : V(vertices), capacity(vertices, vector<int>(vertices, 0)), 
-                                  flow(vertices, vector<int>(vertices, 0)), parent(vertices, -1) {}
+    FordFulkerson(int vertices) : V(vertices), capacity(vertices, vector<Cap>(vertices, 0)), 
+                                  flow(vertices, vector<Cap>(vertices, 0)), parent(vertices, -1) {}
+
+    // Параллельные дуги u -> v складываются в одну
+    void addEdge(int u, int v, Cap cap) {
+        capacity[u][v] += cap;
+    }
+
+    void setVerbose(bool value) {
+        verbose = value;
+    }
+
+    // Масштабирование ёмкостей: в фазе с порогом delta ищутся пути только по остаточным
+    // рёбрам с ёмкостью >= delta, после фазы delta делится пополам (до 1). Тонкие рёбра
+    // не тратят итерации, пока по толстым ещё можно пустить большой поток
+    void setScaling(bool value) {
+        scaling = value;
+    }
 
-    void addEdge(int u, int v, int cap) {
-        capacity[u][v] = cap;
+    int getIterations() const {
+        return lastIterations;
     }
 
-    bool bfs(int source, int end) {
+    // Память под матрицы ёмкостей и потоков, байт
+    size_t memoryBytes() const {
+        return 2 * size_t(V) * V * sizeof(Cap) + parent.size() * sizeof(int);
+    }
+
+    // Кратчайший путь по рёбрам с остаточной ёмкостью не меньше delta
+    bool bfs(int source, int end, Cap delta = 1) {
         fill(parent.begin(), parent.end(), -1);
         vector<bool> visited(V, false);
         queue<int> q;
@@ -34,7 +73,7 @@ public:
             q.pop();
 
             for (int v = 0; v < V; ++v) {
-                if (!visited[v] && capacity[u][v] > flow[u][v]) {
+                if (!visited[v] && capacity[u][v] - flow[u][v] >= delta) {
                     q.push(v);
                     visited[v] = true;
                     parent[v] = u;
@@ -45,33 +84,48 @@ public:
         return false;
     }
 
-    int maxFlow(int source, int end) {
-        int totalFlow = 0;
+    // Каждый вызов считает поток с нуля
+    Cap maxFlow(int source, int end) {
+        for (auto& row : flow) fill(row.begin(), row.end(), 0);
+        Cap totalFlow = 0;
         int iterations = 0;
 
-        while (bfs(source, end)) {
-            ++iterations;
-            int pathFlow = INT_MAX;
-            int s = end;
-
-            while (s != source) {
-                int u = parent[s];
-                pathFlow = min(pathFlow, capacity[u][s] - flow[u][s]);
-                s = u;
+        // Без масштабирования - одна фаза с delta = 1, то есть обычный поиск любого пути
+        Cap delta = 1;
+        if (scaling) {
+            Cap maxCapacity = 0;
+            for (const auto& row : capacity) {
+                for (Cap cap : row) maxCapacity = max(maxCapacity, cap);
             }
+            while (delta <= maxCapacity / 2) delta *= 2;
+        }
 
-            s = end;
-            while (s != source) {
-                int u = parent[s];
-                flow[u][s] += pathFlow;
-                flow[s][u] -= pathFlow;
-                s = u;
-            }
+        for (; delta >= 1; delta /= 2) {
+            while (bfs(source, end, delta)) {
+                ++iterations;
+                Cap pathFlow = numeric_limits<Cap>::max();
+                int s = end;
 
-            totalFlow += pathFlow;
+                while (s != source) {
+                    int u = parent[s];
+                    pathFlow = min(pathFlow, capacity[u][s] - flow[u][s]);
+                    s = u;
+                }
+
+                s = end;
+                while (s != source) {
+                    int u = parent[s];
+                    flow[u][s] += pathFlow;
+                    flow[s][u] -= pathFlow;
+                    s = u;
+                }
+
+                totalFlow += pathFlow;
+            }
         }
 
-        cout << "Итераций: " << iterations << endl;
+        lastIterations = iterations;
+        if (verbose) cout << "Итераций" << (scaling ? " (с масштабированием)" : "") << ": " << iterations << endl;
         return totalFlow;
     }
 
@@ -110,10 +164,639 @@ public:
     
 };
 
+// ---------------------------------------------------------------------------
+// Большие сети: формат DIMACS, генераторы и разреженные решатели
+// ---------------------------------------------------------------------------
+
+// Дуга сети: u -> v с пропускной способностью cap
+struct FlowArc {
+    int u, v;
+    long long cap;
+};
+
+// Сеть для задачи о максимальном потоке, вершины нумеруются с 0
+struct FlowNetwork {
+    int n = 0;
+    int source = 0;
+    int sink = 0;
+    vector<FlowArc> arcs;
+};
+
+// Буферизованное чтение файла в формате DIMACS max-flow:
+//   c комментарий
+//   p max N M
+//   n ID s | n ID t
+//   a U V CAP
+class DimacsReader {
+    static const size_t BUFFER_SIZE = 1 << 16;
+    FILE* file;
+    vector<char> buffer;
+    size_t pos = 0;
+    size_t len = 0;
+
+    int peek() {
+        if (pos == len) {
+            len = fread(buffer.data(), 1, buffer.size(), file);
+            pos = 0;
+            if (len == 0) return EOF;
+        }
+        return (unsigned char)buffer[pos];
+    }
+
+    int get() {
+        int c = peek();
+        if (c != EOF) ++pos;
+        return c;
+    }
+
+    void skipLine() {
+        int c;
+        while ((c = get()) != EOF && c != '\n') {}
+    }
+
+    void skipSpaces() {
+        int c;
+        while ((c = peek()) == ' ' || c == '\t' || c == '\r') ++pos;
+    }
+
+    long long readNumber() {
+        skipSpaces();
+        bool negative = false;
+        if (peek() == '-') {
+            negative = true;
+            ++pos;
+        }
+        int c = peek();
+        if (c < '0' || c > '9') throw runtime_error("DIMACS: ожидалось число");
+        // накапливаем отрицательное значение: его диапазон включает LLONG_MIN
+        long long value = 0;
+        while ((c = peek()) >= '0' && c <= '9') {
+            int digit = c - '0';
+            if (value < (LLONG_MIN + digit) / 10) throw runtime_error("DIMACS: слишком большое число");
+            value = value * 10 - digit;
+            ++pos;
+        }
+        if (!negative) {
+            if (value == LLONG_MIN) throw runtime_error("DIMACS: слишком большое число");
+            value = -value;
+        }
+        return value;
+    }
+
+    // Номера вершин и их количество должны помещаться в int
+    int readInt() {
+        long long value = readNumber();
+        if (value < INT_MIN || value > INT_MAX) throw runtime_error("DIMACS: число вне диапазона int");
+        return (int)value;
+    }
+
+    string readWord() {
+        skipSpaces();
+        string word;
+        int c;
+        while ((c = peek()) != EOF && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+            word += (char)c;
+            ++pos;
+        }
+        if (word.empty()) throw runtime_error("DIMACS: ожидалось слово");
+        return word;
+    }
+
+public:
+    explicit DimacsReader(FILE* f) : file(f), buffer(BUFFER_SIZE) {}
+
+    FlowNetwork read() {
+        FlowNetwork net;
+        bool hasProblem = false, hasSource = false, hasSink = false;
+        int c;
+        while ((c = get()) != EOF) {
+            if (c == 'p') {
+                if (readWord() != "max") throw runtime_error("DIMACS: поддерживается только задача max");
+                net.n = readInt();
+                long long m = readNumber();
+                if (net.n < 1 || m < 0) throw runtime_error("DIMACS: неверные размеры сети");
+                net.arcs.reserve((size_t)min(m, 1LL << 24));
+                hasProblem = true;
+            } else if (c == 'n') {
+                int id = readInt() - 1;
+                string kind = readWord();
+                if (kind == "s") { net.source = id; hasSource = true; }
+                else if (kind == "t") { net.sink = id; hasSink = true; }
+                else throw runtime_error("DIMACS: неизвестный тип вершины");
+            } else if (c == 'a') {
+                if (!hasProblem) throw runtime_error("DIMACS: дуга до строки p");
+                FlowArc arc;
+                arc.u = readInt() - 1;
+                arc.v = readInt() - 1;
+                arc.cap = readNumber();
+                if (arc.u < 0 || arc.u >= net.n || arc.v < 0 || arc.v >= net.n)
+                    throw runtime_error("DIMACS: номер вершины вне диапазона");
+                if (arc.cap < 0) throw runtime_error("DIMACS: отрицательная пропускная способность");
+                net.arcs.push_back(arc);
+            } else if (c == '\n' || c == '\r') {
+                continue;
+            }
+            skipLine();
+        }
+        if (!hasProblem || !hasSource || !hasSink)
+            throw runtime_error("DIMACS: нет строки p или вершин s/t");
+        if (net.source < 0 || net.source >= net.n || net.sink < 0 || net.sink >= net.n)
+            throw runtime_error("DIMACS: источник или сток вне диапазона вершин");
+        if (net.source == net.sink)
+            throw runtime_error("DIMACS: источник совпадает со стоком");
+        return net;
+    }
+};
+
+// Буферизованная запись сети в формате DIMACS
+class DimacsWriter {
+    FILE* file;
+    vector<char> buffer;
+    size_t len = 0;
+
+    void flush() {
+        if (len > 0 && fwrite(buffer.data(), 1, len, file) != len)
+            throw runtime_error("DIMACS: ошибка записи");
+        len = 0;
+    }
+
+    void put(const char* s) {
+        while (*s) {
+            if (len == buffer.size()) flush();
+            buffer[len++] = *s++;
+        }
+    }
+
+    void put(long long value) {
+        if (buffer.size() - len < 24) flush();
+        len = to_chars(buffer.data() + len, buffer.data() + buffer.size(), value).ptr - buffer.data();
+    }
+
+public:
+    explicit DimacsWriter(FILE* f) : file(f), buffer(1 << 16) {}
+
+    void write(const FlowNetwork& net, const string& comment = "") {
+        if (!comment.empty()) {
+            put("c ");
+            put(comment.c_str());
+            put("\n");
+        }
+        put("p max "); put((long long)net.n); put(" "); put((long long)net.arcs.size()); put("\n");
+        put("n "); put((long long)net.source + 1); put(" s\n");
+        put("n "); put((long long)net.sink + 1); put(" t\n");
+        for (const auto& arc : net.arcs) {
+            put("a "); put((long long)arc.u + 1);
+            put(" "); put((long long)arc.v + 1);
+            put(" "); put(arc.cap); put("\n");
+        }
+        flush();
+        if (fflush(file) != 0) throw runtime_error("DIMACS: ошибка записи");
+    }
+};
+
+// Генераторы стандартных трудных семейств сетей
+class FlowGenerator {
+public:
+    // "Компьютерное зрение": решётка rows x cols с 4-связностью,
+    // каждый пиксель связан с истоком и стоком (сегментация изображений)
+    static FlowNetwork grid(int rows, int cols, int maxCap, unsigned seed) {
+        mt19937 gen(seed);
+        uniform_int_distribution<int> capDist(1, maxCap);
+        uniform_int_distribution<int> termDist(0, 2 * maxCap);
+
+        FlowNetwork net;
+        net.n = rows * cols + 2;
+        net.source = rows * cols;
+        net.sink = rows * cols + 1;
+        net.arcs.reserve(size_t(rows) * cols * 6);
+
+        for (int r = 0; r < rows; ++r) {
+            for (int c = 0; c < cols; ++c) {
+                int id = r * cols + c;
+                if (c + 1 < cols) {
+                    net.arcs.push_back({id, id + 1, capDist(gen)});
+                    net.arcs.push_back({id + 1, id, capDist(gen)});
+                }
+                if (r + 1 < rows) {
+                    net.arcs.push_back({id, id + cols, capDist(gen)});
+                    net.arcs.push_back({id + cols, id, capDist(gen)});
+                }
+                // пиксель тянется либо к "объекту", либо к "фону"
+                int fg = termDist(gen) - maxCap;
+                if (fg > 0) net.arcs.push_back({net.source, id, fg});
+                else if (fg < 0) net.arcs.push_back({id, net.sink, -fg});
+            }
+        }
+        return net;
+    }
+
+    // Слоистая случайная сеть: layers слоёв по width вершин,
+    // каждая вершина связана с degree случайными вершинами следующего слоя
+    static FlowNetwork layered(int layers, int width, int degree, int maxCap, unsigned seed) {
+        mt19937 gen(seed);
+        uniform_int_distribution<int> capDist(1, maxCap);
+        uniform_int_distribution<int> pick(0, width - 1);
+
+        FlowNetwork net;
+        net.n = layers * width + 2;
+        net.source = layers * width;
+        net.sink = layers * width + 1;
+        net.arcs.reserve(size_t(layers) * width * degree + 2 * size_t(width));
+
+        for (int i = 0; i < width; ++i) {
+            net.arcs.push_back({net.source, i, (long long)maxCap * degree});
+            net.arcs.push_back({(layers - 1) * width + i, net.sink, (long long)maxCap * degree});
+        }
+        for (int l = 0; l + 1 < layers; ++l) {
+            for (int i = 0; i < width; ++i) {
+                for (int d = 0; d < degree; ++d) {
+                    net.arcs.push_back({l * width + i, (l + 1) * width + pick(gen), capDist(gen)});
+                }
+            }
+        }
+        return net;
+    }
+
+    // Сеть по мотивам генератора AK (Черкасский, Гольдберг), k >= 1.
+    // Первый модуль — длинная цепочка с единичными отводами в сток:
+    // каждый следующий увеличивающий путь на одну дугу длиннее (O(k^2) для BFS-методов).
+    // Второй модуль — две параллельные цепочки с единичными перемычками,
+    // на которых метки расстояний приходится пересчитывать много раз.
+    static FlowNetwork ak(int k) {
+        FlowNetwork net;
+        net.n = 3 * k + 2;
+        net.source = 0;
+        net.sink = 1;
+        net.arcs.reserve(6 * size_t(k) + 2);
+
+        auto a = [&](int i) { return 2 + i; };
+        auto b = [&](int i) { return 2 + k + i; };
+        auto c = [&](int i) { return 2 + 2 * k + i; };
+
+        net.arcs.push_back({net.source, a(0), k});
+        for (int i = 0; i < k; ++i) {
+            if (i + 1 < k) net.arcs.push_back({a(i), a(i + 1), k - i - 1});
+            net.arcs.push_back({a(i), net.sink, 1});
+        }
+
+        net.arcs.push_back({net.source, b(0), k});
+        for (int i = 0; i < k; ++i) {
+            if (i + 1 < k) {
+                net.arcs.push_back({b(i), b(i + 1), k});
+                net.arcs.push_back({c(i), c(i + 1), k});
+            }
+            net.arcs.push_back({b(i), c(i), 1});
+        }
+        net.arcs.push_back({c(k - 1), net.sink, k});
+        return net;
+    }
+
+    // Двудольная сеть: left x right, у каждой левой вершины degree случайных соседей
+    static FlowNetwork bipartite(int left, int right, int degree, int maxCap, unsigned seed) {
+        mt19937 gen(seed);
+        uniform_int_distribution<int> capDist(1, maxCap);
+        uniform_int_distribution<int> pick(0, right - 1);
+
+        FlowNetwork net;
+        net.n = left + right + 2;
+        net.source = left + right;
+        net.sink = left + right + 1;
+        net.arcs.reserve(size_t(left) * (degree + 1) + right);
+
+        for (int i = 0; i < left; ++i) {
+            net.arcs.push_back({net.source, i, capDist(gen)});
+            for (int d = 0; d < degree; ++d) {
+                net.arcs.push_back({i, left + pick(gen), capDist(gen)});
+            }
+        }
+        for (int j = 0; j < right; ++j) {
+            net.arcs.push_back({left + j, net.sink, capDist(gen)});
+        }
+        return net;
+    }
+};
+
+// Остаточная сеть в виде массивов: дуга 2i — прямая дуга i, 2i+1 — обратная к ней.
+// Списки смежности хранятся в CSR (start/adj), без отдельной аллокации на дугу.
+class ResidualGraph {
+public:
+    int n;
+    vector<int> to;
+    vector<long long> cap;
+    vector<int> start;
+    vector<int> adj;
+
+    explicit ResidualGraph(const FlowNetwork& net)
+        : n(net.n), to(2 * net.arcs.size()), cap(2 * net.arcs.size()),
+          start(net.n + 1, 0), adj(2 * net.arcs.size()) {
+        for (size_t i = 0; i < net.arcs.size(); ++i) {
+            to[2 * i] = net.arcs[i].v;
+            cap[2 * i] = net.arcs[i].cap;
+            to[2 * i + 1] = net.arcs[i].u;
+            cap[2 * i + 1] = 0;
+            ++start[net.arcs[i].u + 1];
+            ++start[net.arcs[i].v + 1];
+        }
+        for (int v = 0; v < n; ++v) start[v + 1] += start[v];
+        vector<int> fill(start.begin(), start.end() - 1);
+        for (size_t e = 0; e < to.size(); ++e) {
+            adj[fill[to[e ^ 1]]++] = (int)e;
+        }
+    }
+
+    int from(int e) const {
+        return to[e ^ 1];
+    }
+
+    size_t memoryBytes() const {
+        return to.size() * sizeof(int) + cap.size() * sizeof(long long)
+             + start.size() * sizeof(int) + adj.size() * sizeof(int);
+    }
+};
+
+// Эдмондс-Карп на списках смежности: кратчайший увеличивающий путь за O(E)
+class EdmondsKarp {
+    ResidualGraph g;
+    long long augmentations = 0;
+
+public:
+    explicit EdmondsKarp(const FlowNetwork& net) : g(net) {}
+
+    long long maxFlow(int source, int sink) {
+        long long total = 0;
+        vector<int> parentEdge(g.n);
+        vector<int> q(g.n);
+
+        while (true) {
+            fill(parentEdge.begin(), parentEdge.end(), -1);
+            parentEdge[source] = -2;
+            int head = 0, tail = 0;
+            q[tail++] = source;
+            while (head < tail && parentEdge[sink] == -1) {
+                int u = q[head++];
+                for (int i = g.start[u]; i < g.start[u + 1]; ++i) {
+                    int e = g.adj[i];
+                    int v = g.to[e];
+                    if (parentEdge[v] == -1 && g.cap[e] > 0) {
+                        parentEdge[v] = e;
+                        q[tail++] = v;
+                    }
+                }
+            }
+            if (parentEdge[sink] == -1) break;
+
+            long long pathFlow = LLONG_MAX;
+            for (int v = sink; v != source; v = g.from(parentEdge[v])) {
+                pathFlow = min(pathFlow, g.cap[parentEdge[v]]);
+            }
+            for (int v = sink; v != source; v = g.from(parentEdge[v])) {
+                g.cap[parentEdge[v]] -= pathFlow;
+                g.cap[parentEdge[v] ^ 1] += pathFlow;
+            }
+            total += pathFlow;
+            ++augmentations;
+        }
+        return total;
+    }
+
+    long long getAugmentations() const {
+        return augmentations;
+    }
+
+    size_t memoryBytes() const {
+        return g.memoryBytes() + 2 * size_t(g.n) * sizeof(int);
+    }
+};
+
+// Алгоритм Диница: слоистая сеть + блокирующий поток.
+// Поиск путей в слоистой сети итеративный, глубина пути не ограничена стеком.
+class Dinic {
+    ResidualGraph g;
+    vector<int> level;
+    vector<int> current;
+    vector<int> q;
+    long long augmentations = 0;
+
+    bool buildLevels(int source, int sink) {
+        fill(level.begin(), level.end(), -1);
+        int head = 0, tail = 0;
+        q[tail++] = source;
+        level[source] = 0;
+        while (head < tail) {
+            int u = q[head++];
+            for (int i = g.start[u]; i < g.start[u + 1]; ++i) {
+                int e = g.adj[i];
+                if (g.cap[e] > 0 && level[g.to[e]] < 0) {
+                    level[g.to[e]] = level[u] + 1;
+                    q[tail++] = g.to[e];
+                }
+            }
+        }
+        return level[sink] >= 0;
+    }
+
+    long long blockingFlow(int source, int sink) {
+        long long total = 0;
+        vector<int> path;
+        int u = source;
+        while (true) {
+            if (u == sink) {
+                long long pathFlow = LLONG_MAX;
+                for (int e : path) pathFlow = min(pathFlow, g.cap[e]);
+                size_t firstSaturated = path.size();
+                for (size_t i = 0; i < path.size(); ++i) {
+                    g.cap[path[i]] -= pathFlow;
+                    g.cap[path[i] ^ 1] += pathFlow;
+                    if (g.cap[path[i]] == 0 && firstSaturated == path.size()) firstSaturated = i;
+                }
+                total += pathFlow;
+                ++augmentations;
+                // откатываемся к началу первой насыщенной дуги
+                path.resize(firstSaturated);
+                u = path.empty() ? source : g.to[path.back()];
+                continue;
+            }
+
+            bool advanced = false;
+            for (int& i = current[u]; i < g.start[u + 1]; ++i) {
+                int e = g.adj[i];
+                if (g.cap[e] > 0 && level[g.to[e]] == level[u] + 1) {
+                    path.push_back(e);
+                    u = g.to[e];
+                    advanced = true;
+                    break;
+                }
+            }
+            if (advanced) continue;
+
+            // тупик: вершина больше не участвует в этой фазе
+            level[u] = -1;
+            if (path.empty()) break;
+            u = g.from(path.back());
+            path.pop_back();
+            ++current[u];
+        }
+        return total;
+    }
+
+public:
+    explicit Dinic(const FlowNetwork& net) : g(net), level(net.n), current(net.n), q(net.n) {}
+
+    long long maxFlow(int source, int sink) {
+        long long total = 0;
+        while (buildLevels(source, sink)) {
+            for (int v = 0; v < g.n; ++v) current[v] = g.start[v];
+            total += blockingFlow(source, sink);
+        }
+        return total;
+    }
+
+    long long getAugmentations() const {
+        return augmentations;
+    }
+
+    size_t memoryBytes() const {
+        return g.memoryBytes() + (level.size() + current.size() + q.size()) * sizeof(int);
+    }
+};
+
+// Результат одного запуска решателя
+struct SolverRun {
+    string solver;
+    bool skipped = false;
+    long long flow = 0;
+    double ms = 0;
+    long long augmentations = 0;
+    size_t bytes = 0;
+};
+
+class FlowBenchmark {
+public:
+    // Ограничения, при которых решатель ещё укладывается в разумное время/память
+    static const int MATRIX_MAX_VERTICES = 2000;
+    // у Эдмондса-Карпа число итераций растёт с V, поэтому ограничиваем V * E
+    static constexpr double EDMONDS_KARP_MAX_WORK = 2e9;
+
+    static vector<SolverRun> runAll(const FlowNetwork& net) {
+        vector<SolverRun> runs;
+
+        for (bool scaling : {false, true}) {
+            SolverRun matrix;
+            matrix.solver = scaling ? "FordFulkerson (масштаб.)" : "FordFulkerson (матрица)";
+            if (net.n <= MATRIX_MAX_VERTICES) {
+                auto startTime = chrono::steady_clock::now();
+                FordFulkerson<> ff(net.n);
+                ff.setVerbose(false);
+                ff.setScaling(scaling);
+                for (const auto& arc : net.arcs) ff.addEdge(arc.u, arc.v, arc.cap);
+                matrix.flow = ff.maxFlow(net.source, net.sink);
+                matrix.ms = elapsedMs(startTime);
+                matrix.augmentations = ff.getIterations();
+                matrix.bytes = ff.memoryBytes();
+            } else {
+                matrix.skipped = true;
+            }
+            runs.push_back(matrix);
+        }
+
+        SolverRun ek;
+        ek.solver = "Эдмондс-Карп";
+        if (double(net.n) * net.arcs.size() <= EDMONDS_KARP_MAX_WORK) {
+            auto startTime = chrono::steady_clock::now();
+            EdmondsKarp solver(net);
+            ek.flow = solver.maxFlow(net.source, net.sink);
+            ek.ms = elapsedMs(startTime);
+            ek.augmentations = solver.getAugmentations();
+            ek.bytes = solver.memoryBytes();
+        } else {
+            ek.skipped = true;
+        }
+        runs.push_back(ek);
+
+        SolverRun dinic;
+        dinic.solver = "Диниц";
+        auto startTime = chrono::steady_clock::now();
+        Dinic solver(net);
+        dinic.flow = solver.maxFlow(net.source, net.sink);
+        dinic.ms = elapsedMs(startTime);
+        dinic.augmentations = solver.getAugmentations();
+        dinic.bytes = solver.memoryBytes();
+        runs.push_back(dinic);
+
+        return runs;
+    }
+
+    // Печатает результаты и проверяет, что все решатели нашли один и тот же поток
+    static bool report(const string& name, const FlowNetwork& net, const vector<SolverRun>& runs) {
+        cout << "\n" << name << ": V = " << net.n << ", E = " << net.arcs.size() << "\n";
+        bool consistent = true;
+        long long reference = -1;
+        for (const auto& run : runs) {
+            cout << "  " << padRight(run.solver, 26);
+            if (run.skipped) {
+                cout << "пропущен (слишком большой граф)\n";
+                continue;
+            }
+            cout << "поток " << setw(12) << run.flow
+                 << "  время " << setw(10) << fixed << setprecision(2) << run.ms << " мс"
+                 << "  аугментаций " << setw(9) << run.augmentations
+                 << "  память " << setw(8) << setprecision(2) << run.bytes / (1024.0 * 1024.0) << " МБ" << endl;
+            if (reference < 0) reference = run.flow;
+            else if (reference != run.flow) consistent = false;
+        }
+        if (!consistent) cout << "  ОШИБКА: решатели нашли разные потоки!\n";
+        return consistent;
+    }
+
+    // Набор от малых графов до ~10^6 дуг; scale увеличивает линейные размеры
+    static bool runSuite(double scale) {
+        bool ok = true;
+        auto sized = [&](int base) { return max(2, int(base * scale)); };
+
+        for (int side : {30, 120, 450}) {
+            int s = sized(side);
+            auto net = FlowGenerator::grid(s, s, 100, 1);
+            ok &= report("Решётка " + to_string(s) + "x" + to_string(s), net, runAll(net));
+        }
+        for (int width : {20, 100, 300}) {
+            int w = sized(width);
+            auto net = FlowGenerator::layered(w, w, 6, 1000, 2);
+            ok &= report("Слоистая " + to_string(w) + "x" + to_string(w), net, runAll(net));
+        }
+        // AK квадратичен для методов кратчайших путей, поэтому k умеренные
+        for (int k : {300, 1000, 3000}) {
+            int kk = sized(k);
+            auto net = FlowGenerator::ak(kk);
+            ok &= report("AK k=" + to_string(kk), net, runAll(net));
+        }
+        for (int half : {500, 20000, 120000}) {
+            int h = sized(half);
+            auto net = FlowGenerator::bipartite(h, h, 8, 1, 3);
+            ok &= report("Двудольная " + to_string(h) + "+" + to_string(h), net, runAll(net));
+        }
+        cout << (ok ? "\nВсе решатели согласованы\n" : "\nЕсть расхождения!\n");
+        return ok;
+    }
+
+private:
+    // setw считает байты, а не символы UTF-8, поэтому выравниваем вручную
+    static string padRight(const string& s, size_t width) {
+        size_t chars = 0;
+        for (unsigned char c : s) {
+            if ((c & 0xC0) != 0x80) ++chars;
+        }
+        return chars < width ? s + string(width - chars, ' ') : s;
+    }
+
+    static double elapsedMs(chrono::steady_clock::time_point startTime) {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+    }
+};
+
 // Тест 1: Простой граф
 void test1() {
     cout << "\nТест 1 - Простой граф\n";  
-    FordFulkerson ff(6);
+    FordFulkerson<> ff(6);
     ff.addEdge(0, 1, 16);
     ff.addEdge(0, 2, 13);
     ff.addEdge(1, 2, 10);
@@ -126,14 +809,14 @@ void test1() {
 
     ff.printGraph();
     cout << "Размер графа: " << ff.getEdgeCount() << endl;
-    int max_flow = ff.maxFlow(0, 5);
+    long long max_flow = ff.maxFlow(0, 5);
     cout << "Максимальный поток: " << max_flow << endl;
 }
 
 // Тест 2: Граф медленной работы (большое число итераций)
 void test2() {
     cout << "\nТест 2 - Очень медленный граф\n";
-    FordFulkerson ff(6);
+    FordFulkerson<> ff(6);
     
     ff.addEdge(0, 1, 100);
     ff.addEdge(0, 2, 100);
@@ -146,29 +829,34 @@ void test2() {
 
     ff.printGraph();
     cout << "Размер графа: " << ff.getEdgeCount() << endl;
-    int max_flow = ff.maxFlow(0, 5);
+    long long max_flow = ff.maxFlow(0, 5);
     cout << "Максимальный поток: " << max_flow << endl;
+
+    // Пока delta > 1, рёбра ёмкости 1 не рассматриваются и поток идёт по рёбрам ёмкости 100
+    ff.setScaling(true);
+    max_flow = ff.maxFlow(0, 5);
+    cout << "Максимальный поток с масштабированием: " << max_flow << endl;
 }
 
 
 // Тест 3: Граф несходимости (нет пути от источника к стоку)
 void test3() {
     cout << "\nТест 3 - Граф несходимости\n";
-    FordFulkerson ff(4);
+    FordFulkerson<> ff(4);
     ff.addEdge(0, 1, 10);
     ff.addEdge(1, 2, 5);
     ff.addEdge(2, 3, 8); // Убираем связь между 0 и 3 напрямую
 
     ff.printGraph();
     cout << "Размер графа: " << ff.getEdgeCount() << endl;
-    int max_flow = ff.maxFlow(0, 3);
+    long long max_flow = ff.maxFlow(0, 3);
     cout << "Максимальный поток: " << max_flow << endl;
 }
 
 // Тест 4: Циклический граф с несколькими путями
 void test4() {
     cout << "\nТест 4 - Граф с несколькими путями\n";
-    FordFulkerson ff(5);
+    FordFulkerson<> ff(5);
     ff.addEdge(0, 1, 12);
     ff.addEdge(0, 2, 10);
     ff.addEdge(1, 2, 5);
@@ -178,17 +866,102 @@ void test4() {
 
     ff.printGraph();
     cout << "Размер графа: " << ff.getEdgeCount() << endl;
-    int max_flow = ff.maxFlow(0, 4);
+    long long max_flow = ff.maxFlow(0, 4);
     cout << "Максимальный поток: " << max_flow << endl;
 }
 
-int main() {
-    cout << "Реализация алгоритма Форда-Фалкерсона\n";
+// Тест 5: Ёмкости порядка миллиардов (в int сумма переполнилась бы)
+void test5() {
+    cout << "\nТест 5 - Большие ёмкости\n";
+    FordFulkerson<> ff(4);
+    ff.addEdge(0, 1, 3000000000LL);
+    ff.addEdge(0, 2, 2000000000LL);
+    ff.addEdge(1, 2, 1500000000LL);
+    ff.addEdge(1, 3, 2500000000LL);
+    ff.addEdge(2, 3, 2500000000LL);
+
+    ff.printGraph();
+    cout << "Размер графа: " << ff.getEdgeCount() << endl;
+    long long max_flow = ff.maxFlow(0, 3);
+    cout << "Максимальный поток: " << max_flow << endl;
+
+    ff.setScaling(true);
+    max_flow = ff.maxFlow(0, 3);
+    cout << "Максимальный поток с масштабированием: " << max_flow << endl;
+}
 
-    test1();
-    test2();
-    test3();
-    test4();
+// Генерация сети семейства family с параметром размера size
+FlowNetwork generateNetwork(const string& family, int size, unsigned seed) {
+    if (size < 1) throw runtime_error("размер сети должен быть не меньше 1");
+    // число вершин (с истоком и стоком) считается в 64 битах: номера вершин должны помещаться в int
+    long long vertices;
+    if (family == "grid" || family == "layered") vertices = (long long)size * size + 2;
+    else if (family == "ak") vertices = 3LL * size + 2;
+    else if (family == "bipartite") vertices = 2LL * size + 2;
+    else throw runtime_error("неизвестное семейство: " + family);
+    if (vertices > INT_MAX) throw runtime_error("слишком большой размер сети: " + to_string(size));
+
+    if (family == "grid") return FlowGenerator::grid(size, size, 100, seed);
+    if (family == "layered") return FlowGenerator::layered(size, size, 6, 1000, seed);
+    if (family == "ak") return FlowGenerator::ak(size);
+    if (family == "bipartite") return FlowGenerator::bipartite(size, size, 8, 1, seed);
+    throw runtime_error("неизвестное семейство: " + family);
+}
+
+void printUsage() {
+    cout << "Использование:\n"
+         << "  lab4                                    - тесты на малых графах\n"
+         << "  lab4 gen <grid|layered|ak|bipartite> <размер> <seed> <файл|->  - записать сеть в DIMACS\n"
+         << "  lab4 solve <файл.max>                   - решить сеть из файла DIMACS\n"
+         << "  lab4 bench [масштаб]                    - набор тестов производительности\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 1) {
+        cout << "Реализация алгоритма Форда-Фалкерсона\n";
+
+        test1();
+        test2();
+        test3();
+        test4();
+        test5();
+
+        return 0;
+    }
+
+    try {
+        string mode = argv[1];
+        if (mode == "gen" && argc == 6) {
+            auto net = generateNetwork(argv[2], stoi(argv[3]), (unsigned)stoul(argv[4]));
+            string path = argv[5];
+            FILE* out = path == "-" ? stdout : fopen(path.c_str(), "wb");
+            if (!out) throw runtime_error("не удалось открыть " + path);
+            try {
+                DimacsWriter(out).write(net, string(argv[2]) + " " + argv[3] + " seed " + argv[4]);
+            } catch (...) {
+                if (out != stdout) fclose(out);
+                throw;
+            }
+            if (out != stdout && fclose(out) != 0) throw runtime_error("ошибка записи в " + path);
+        } else if (mode == "solve" && argc == 3) {
+            FILE* in = fopen(argv[2], "rb");
+            if (!in) throw runtime_error(string("не удалось открыть ") + argv[2]);
+            auto startTime = chrono::steady_clock::now();
+            FlowNetwork net = DimacsReader(in).read();
+            fclose(in);
+            cout << "Чтение: " << fixed << setprecision(2)
+                 << chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count() << " мс\n";
+            return FlowBenchmark::report(argv[2], net, FlowBenchmark::runAll(net)) ? 0 : 1;
+        } else if (mode == "bench" && argc <= 3) {
+            return FlowBenchmark::runSuite(argc == 3 ? stod(argv[2]) : 1.0) ? 0 : 1;
+        } else {
+            printUsage();
+            return 1;
+        }
+    } catch (const exception& e) {
+        cerr << "Ошибка: " << e.what() << endl;
+        return 1;
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -4,7 +4,11 @@
 #include <string>
 #include <algorithm>
 #include <map>
-#include <list>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <cstdint>
 using namespace std;
 
 struct Edge {
@@ -14,12 +18,14 @@ struct Edge {
   int flow; // поток через дугу
   int flow_capacity; // пропускная способность дуги
 
-  Edge(int from_number_, int to_number, int flow_, int flow_capacity_) :
+  int anti_edge; // индекс антидуги в массиве дуг графа
+
+  Edge(int from_number_, int to_number, int flow_, int flow_capacity_, int anti_edge_) :
     from_number(from_number_), to_number(to_number),
-    flow(flow_), flow_capacity(flow_capacity_) {
+    flow(flow_), flow_capacity(flow_capacity_), anti_edge(anti_edge_) {
   }
 
-  int residual_flow() { // остаточный поток
+  int residual_flow() const { // остаточный поток
     return flow_capacity - flow;
   }
 };
@@ -27,90 +33,237 @@ struct Edge {
 struct Node {
   int number;
   char letter;
-  vector<Edge*> adjacent; // список инцидентности
+  vector<int> adjacent; // список инцидентности - индексы дуг в FlowGraph::edges
 
   Node(int number_) : number(number_) { }
+};
+
+// все дуги графа лежат в одном плоском массиве
+// дуга и ее антидуга добавляются парой и хранят индексы друг друга,
+// поэтому антидугу не надо искать перебором списка инцидентности
+struct FlowGraph {
+  vector<Node> nodes;
+  vector<Edge> edges;
 
-  ~Node() {
-    for (auto& edge : adjacent)
-      delete edge;
+  int add_node() {
+    nodes.emplace_back(nodes.size());
+    return nodes.size() - 1;
+  }
+
+  void add_edge(int from_number, int to_number, int flow_capacity) {
+    const int index = edges.size();
+    edges.emplace_back(from_number, to_number, 0, flow_capacity, index + 1);
+    edges.emplace_back(to_number, from_number, 0, 0, index);
+    nodes[from_number].adjacent.push_back(index);
+    nodes[to_number].adjacent.push_back(index + 1);
   }
 };
 
+// рабочие массивы поиска пути, переиспользуются между итерациями ford_fulkerson
+struct DfsState {
+  // вершина посещена в текущем поиске, если visited_epoch[v] == epoch
+  // новый поиск просто увеличивает epoch, и массив не надо очищать
+  vector<int> visited_epoch;
+  int epoch = 0;
+
+  vector<int> parent_edge; // дуга, по которой пришли в вершину
+  vector<size_t> next_edge; // первая непросмотренная дуга вершины
+  vector<int> stack;
+
+  DfsState(size_t node_count) :
+    visited_epoch(node_count, 0), parent_edge(node_count), next_edge(node_count) {
+  }
+};
 
 // поиск путей между src и dst в графе graph
 // причем, путей, по которым можно еще что-то передать
 // (т.е. не содержащих дуг где flow_capacity-flow == 0)
-bool dfs(vector<Node*>& graph, int src, int dst, list<Edge*>& path, list<int>& visited) {
-  if (src == dst)
-    return true;
+// поиск итеративный, поэтому глубина пути не ограничена размером стека
+// path заполняется индексами дуг от src к dst
+bool dfs(FlowGraph& graph, int src, int dst, vector<int>& path, DfsState& state) {
+  ++state.epoch;
+  state.stack.clear();
+  state.stack.push_back(src);
+  state.visited_epoch[src] = state.epoch;
+  state.next_edge[src] = 0;
+
+  while (!state.stack.empty()) {
+    const int current = state.stack.back();
+    if (current == dst) {
+      path.clear();
+      for (int v = dst; v != src; v = graph.edges[state.parent_edge[v]].from_number)
+        path.push_back(state.parent_edge[v]);
+      reverse(path.begin(), path.end());
+      return true;
+    }
 
-  if (find(visited.begin(), visited.end(), src) != visited.end()) {
-    // если в этой вершине мы уже были
-    return false;
-  }
+    auto& adjacent = graph.nodes[current].adjacent;
+    if (state.next_edge[current] == adjacent.size()) {
+      // из этой вершины пути нет - возвращаюсь
+      state.stack.pop_back();
+      continue;
+    }
 
-  auto& adjacent = graph[src]->adjacent;
-  for (auto edge : adjacent) {
-    if (edge->residual_flow() <= 0)
+    const int index = adjacent[state.next_edge[current]++];
+    const Edge& edge = graph.edges[index];
+    if (edge.residual_flow() <= 0 || state.visited_epoch[edge.to_number] == state.epoch)
       continue;
 
-    // если дуга не загружена - перехожу по ней
-    visited.push_back(src);
-    if (dfs(graph, edge->to_number, dst, path, visited)) {
-      path.push_front(edge);
-      return true;
-    }
+    // если дуга не загружена и вершина еще не посещена - перехожу по ней
+    state.visited_epoch[edge.to_number] = state.epoch;
+    state.parent_edge[edge.to_number] = index;
+    state.next_edge[edge.to_number] = 0;
+    state.stack.push_back(edge.to_number);
   }
 
   return false;
 }
 
-Edge* get_edge(vector<Node*>& graph, int src, int dst) {
-  // граф задан списком инцидентности,
-  // надо взять нужную вершину (src) и перебрать в ней все дуги, пока не попадется dst
-  auto& adjacent = graph[src]->adjacent;
-
-  for (auto edge : adjacent) {
-    if (edge->to_number == dst)
-      return edge;
-  }
-  return nullptr;
-}
-
-int ford_fulkerson(vector<Node*>& graph, int src, int dst) {
+int ford_fulkerson(FlowGraph& graph, int src, int dst) {
   int pathCount = 0;
-  while (true) {
-    list<Edge*> path;
-    list<int> visited;
+  DfsState state(graph.nodes.size());
+  vector<int> path;
 
+  while (true) {
     // если найти путь уже нельзя - возвращаю текущее количество путей
-    if (dfs(graph, src, dst, path, visited) == false)
+    if (dfs(graph, src, dst, path, state) == false)
       break;
 
     pathCount++;
     int min_flow = 1; // в классическом методе - обойти путь и найти в нем минимальную остаточную пропускную способность
     // у всех пройденных дуг увеличиваю поток на величину min_flow
-    // а также нахожу антидугу и уменьшаю поток на ней
-    for (auto edge : path) {
-      edge->flow += min_flow;
-      auto* antiEdge = get_edge(graph, edge->to_number, edge->from_number);
-      antiEdge->flow -= min_flow;
+    // а также уменьшаю поток на антидуге
+    for (int index : path) {
+      auto& edge = graph.edges[index];
+      edge.flow += min_flow;
+      graph.edges[edge.anti_edge].flow -= min_flow;
     }
   }
   return pathCount;
 }
 
-int main() {
-  ifstream ifst("input.txt");
-  ofstream ofst("output.txt");
+// паросочетание Хопкрофта-Карпа в двудольном графе
+// левая доля - буквы имени, правая - кубики
+// каждая фаза ищет в BFS кратчайшую длину увеличивающих путей
+// и затем DFS по слоям находит максимальный набор непересекающихся путей такой длины
+// всего фаз O(sqrt(V)), итоговая сложность O(E*sqrt(V))
+struct HopcroftKarp {
+  static const int INF = 1 << 30;
+
+  int left_count;
+  int right_count;
+  vector<vector<int>> adjacent; // adjacent[буква имени] - номера подходящих кубиков
+
+  vector<int> match_left;  // match_left[буква] - кубик или -1
+  vector<int> match_right; // match_right[кубик] - буква или -1
+  vector<int> dist;        // слой левой вершины в текущей фазе
+
+  HopcroftKarp(int left_count_, int right_count_) :
+    left_count(left_count_), right_count(right_count_), adjacent(left_count_),
+    match_left(left_count_, -1), match_right(right_count_, -1), dist(left_count_) {
+  }
+
+  void add_edge(int letter, int cube) {
+    adjacent[letter].push_back(cube);
+  }
+
+  // разбивает левую долю на слои от свободных букв
+  // возвращает длину кратчайшего увеличивающего пути (в левых вершинах) или INF
+  int bfs() {
+    vector<int> queue;
+    queue.reserve(left_count);
+    for (int u = 0; u < left_count; ++u) {
+      if (match_left[u] == -1) {
+        dist[u] = 0;
+        queue.push_back(u);
+      }
+      else {
+        dist[u] = INF;
+      }
+    }
 
+    int free_layer = INF;
+    for (size_t head = 0; head < queue.size(); ++head) {
+      int u = queue[head];
+      if (dist[u] >= free_layer)
+        break;
+      for (int v : adjacent[u]) {
+        int w = match_right[v];
+        if (w == -1) {
+          free_layer = min(free_layer, dist[u] + 1);
+        }
+        else if (dist[w] == INF) {
+          dist[w] = dist[u] + 1;
+          queue.push_back(w);
+        }
+      }
+    }
+    return free_layer;
+  }
+
+  // итеративный поиск увеличивающего пути из свободной буквы root по слоям
+  // next_edge - сколько дуг каждой буквы уже просмотрено в этой фазе
+  bool augment(int root, int free_layer, vector<size_t>& next_edge, vector<int>& via) {
+    vector<int> stack = { root };
+    while (!stack.empty()) {
+      int u = stack.back();
+      if (next_edge[u] == adjacent[u].size()) {
+        // из буквы больше нет путей - исключаю ее до конца фазы
+        dist[u] = INF;
+        stack.pop_back();
+        continue;
+      }
+
+      int v = adjacent[u][next_edge[u]++];
+      int w = match_right[v];
+      if (w == -1) {
+        if (dist[u] + 1 != free_layer)
+          continue;
+
+        // нашли свободный кубик - перекладываю паросочетание вдоль пути
+        via[u] = v;
+        for (int x : stack) {
+          match_left[x] = via[x];
+          match_right[via[x]] = x;
+        }
+        return true;
+      }
+      if (dist[w] == dist[u] + 1) {
+        via[u] = v;
+        stack.push_back(w);
+      }
+    }
+    return false;
+  }
+
+  int max_matching() {
+    int matching = 0;
+    vector<size_t> next_edge(left_count);
+    vector<int> via(left_count);
+
+    while (true) {
+      int free_layer = bfs();
+      if (free_layer == INF)
+        break;
+
+      fill(next_edge.begin(), next_edge.end(), 0);
+      for (int u = 0; u < left_count; ++u) {
+        if (match_left[u] == -1 && augment(u, free_layer, next_edge, via))
+          matching++;
+      }
+    }
+    return matching;
+  }
+};
+
+// исходное решение через поток в сети (ford_fulkerson)
+// оставлено для сверки с паросочетанием: запуск с ключом --flow
+void solve_with_flow(const string& name, const vector<string>& cubes, ostream& ofst) {
   // граф задан в виде списков инцидентности
   // граф двудольный - одна доля - буквы кубиков
   // другая - буквы имени
   // узел - строка таблицы
-  vector<Node*> graph;
-  string name;
+  FlowGraph graph;
 
   // в имени может быть несколько одинаковых символов, допустим "ANN"
   // если на кубике X есть буква N - она должна быть соединена дугой с обоими буквами имени
@@ -120,30 +273,24 @@ int main() {
   // в строке находятся идентификаторы узлов графа, соответствующие этой букве (имени)
   vector<vector<int>> char_to_id(256);
 
-  size_t n;
-
-  ifst >> n;
-  ifst >> name;
-
+  const size_t n = cubes.size();
   const auto NameLength = name.length();
 
   // всего в графе узлов столько, сколько в сумме в обоих долях
-  graph.resize(n + NameLength);
+  graph.nodes.reserve(n + NameLength + 2);
 
   // первые узлы - символы имени
   for (size_t i = 0; i < NameLength; ++i) {
-    graph[i] = new Node(i);
-    graph[i]->letter = name[i];
-    char_to_id[name[i]].push_back(i);
+    graph.add_node();
+    graph.nodes[i].letter = name[i];
+    char_to_id[(unsigned char)name[i]].push_back(i);
   }
 
   // дальше - кубики (им не задана буква, но заданы смежные узлы)
   for (size_t i = 0; i < n; ++i) {
-    const int blockNodeId = NameLength+i;
-    graph[blockNodeId] = new Node(blockNodeId);
+    const int blockNodeId = graph.add_node();
 
-    string line;
-    ifst >> line;
+    string line = cubes[i];
 
     // если в кубике повторяются символы - удаляю их, так как кубик может быть исопльзован только 1 раз
     std::sort(line.begin(), line.end());
@@ -155,53 +302,46 @@ int main() {
       const auto symbol = line[j];
 
       // буква кубика смежна каким-то буквам имени (возможно нескольким), выбираю номера узлов графа
-      auto& name_letter_ids = char_to_id[symbol];
+      auto& name_letter_ids = char_to_id[(unsigned char)symbol];
 
       for (size_t k = 0; k < name_letter_ids.size(); ++k) {
         auto nameNodeId = name_letter_ids[k];
 
         // для каждой такой пары устанавливаю связь
-        graph[nameNodeId]->adjacent.push_back(new Edge(nameNodeId, blockNodeId, 0, 1));
-        graph[blockNodeId]->adjacent.push_back(new Edge(blockNodeId, nameNodeId, 0, 0));
+        graph.add_edge(nameNodeId, blockNodeId, 1);
       }
     }
   }
 
   // добавляем в конец вершины стока и истока
-  int srcNumber = graph.size();
-  int dstNumber = srcNumber+1;
-
-  graph.push_back(new Node(srcNumber));
-  graph.push_back(new Node(dstNumber));
+  int srcNumber = graph.add_node();
+  int dstNumber = graph.add_node();
 
   // соединяю их
-  for (size_t i = 0; i < NameLength; ++i) {
-    graph[srcNumber]->adjacent.push_back(new Edge(srcNumber, i, 0, 1));
-    graph[i]->adjacent.push_back(new Edge(i, srcNumber, 0, 0));
-  }
+  for (size_t i = 0; i < NameLength; ++i)
+    graph.add_edge(srcNumber, i, 1);
 
-  for (size_t i = NameLength; i < NameLength + n; ++i) {
-    graph[i]->adjacent.push_back(new Edge(i, dstNumber, 0, 1));
-    graph[dstNumber]->adjacent.push_back(new Edge(dstNumber, i, 0, 0));
-  }
+  for (size_t i = NameLength; i < NameLength + n; ++i)
+    graph.add_edge(i, dstNumber, 1);
 
   int pathCount = ford_fulkerson(graph, srcNumber, dstNumber);
-  if (pathCount == NameLength) {
+  if (pathCount == (int)NameLength) {
     ofst << "YES" << endl;
 
     // перебираю узлы графа, соответствующие буквы имени
     for (size_t i = 0; i < NameLength; ++i) {
       if (i > 0)
         ofst << ' ';
-      auto* node = graph[i];
+      auto& node = graph.nodes[i];
 
-      // ofst << endl << node->letter << " ";
-      // для каждой буквы нахожу занятую дугу
-      for (auto& edge : node->adjacent) {
-        if (edge->flow == edge->flow_capacity) {
+      // ofst << endl << node.letter << " ";
+      // для каждой буквы нахожу занятую дугу (антидуги имеют нулевую пропускную способность)
+      for (int index : node.adjacent) {
+        auto& edge = graph.edges[index];
+        if (edge.flow_capacity > 0 && edge.flow == edge.flow_capacity) {
           // отнимаю NameLength, так как узлы кубиков в графе идут после узлов имени
           // +1 так как номерация кубиков начинается с 1, а узлов с 0
-          ofst << (edge->to_number - NameLength + 1);
+          ofst << (edge.to_number - NameLength + 1);
         }
       }
     }
@@ -209,4 +349,366 @@ int main() {
   else {
     ofst << "NO";
   }
-}
\ No newline at end of file
+}
+
+// множество из 256 элементов (буквы алфавита или номера кубиков) в четырех 64-битных словах
+// операции - поэлементные циклы по словам, компилятор разворачивает их в SIMD (SSE/AVX)
+struct Mask256 {
+  uint64_t words[4] = {};
+
+  void set(int bit) {
+    words[bit >> 6] |= uint64_t(1) << (bit & 63);
+  }
+
+  bool test(int bit) const {
+    return (words[bit >> 6] >> (bit & 63)) & 1;
+  }
+
+  bool any() const {
+    return (words[0] | words[1] | words[2] | words[3]) != 0;
+  }
+
+  int count() const {
+    int result = 0;
+    for (uint64_t word : words)
+      result += __builtin_popcountll(word);
+    return result;
+  }
+
+  // номер младшего установленного элемента, множество не должно быть пустым
+  int first() const {
+    for (int i = 0; i < 4; ++i) {
+      if (words[i])
+        return i * 64 + __builtin_ctzll(words[i]);
+    }
+    return -1;
+  }
+
+  // вызывает f для каждого установленного элемента по возрастанию
+  template <typename F>
+  void for_each(F f) const {
+    for (int i = 0; i < 4; ++i) {
+      for (uint64_t word = words[i]; word; word &= word - 1)
+        f(i * 64 + __builtin_ctzll(word));
+    }
+  }
+
+  Mask256 operator&(const Mask256& other) const {
+    Mask256 result;
+    for (int i = 0; i < 4; ++i)
+      result.words[i] = words[i] & other.words[i];
+    return result;
+  }
+
+  Mask256 operator|(const Mask256& other) const {
+    Mask256 result;
+    for (int i = 0; i < 4; ++i)
+      result.words[i] = words[i] | other.words[i];
+    return result;
+  }
+
+  Mask256 operator~() const {
+    Mask256 result;
+    for (int i = 0; i < 4; ++i)
+      result.words[i] = ~words[i];
+    return result;
+  }
+};
+
+// сторона кубиков, общая для всех запросов с одним и тем же набором кубиков:
+// для каждой буквы - номера кубиков, на которых она есть (каждый кубик не более одного раза)
+struct CubeSet {
+  // если кубиков не больше 256, множества кубиков тоже хранятся масками
+  static const size_t MaskCubes = 256;
+
+  vector<string> cubes;
+  vector<Mask256> cube_letters;    // cube_letters[кубик] - буквы на кубике
+  vector<vector<int>> letter_to_cubes;
+  vector<Mask256> letter_cubes;    // letter_cubes[буква] - кубики с этой буквой (только для малых наборов)
+
+  explicit CubeSet(vector<string> cubes_) :
+    cubes(move(cubes_)), cube_letters(cubes.size()), letter_to_cubes(256) {
+    for (size_t i = 0; i < cubes.size(); ++i) {
+      // повторяющиеся буквы кубика сливаются в один бит маски
+      for (unsigned char symbol : cubes[i])
+        cube_letters[i].set(symbol);
+      cube_letters[i].for_each([&](int symbol) {
+        letter_to_cubes[symbol].push_back(i);
+      });
+    }
+
+    if (is_small()) {
+      letter_cubes.resize(256);
+      for (size_t i = 0; i < cubes.size(); ++i) {
+        cube_letters[i].for_each([&](int symbol) {
+          letter_cubes[symbol].set(i);
+        });
+      }
+    }
+  }
+
+  bool is_small() const {
+    return cubes.size() <= MaskCubes;
+  }
+};
+
+// быстрая проверка без паросочетания: каждой букве имени нужен свой кубик,
+// поэтому букв не больше, чем кубиков, и каждая буква встречается в имени
+// не чаще, чем число кубиков с ней
+bool letters_fit(const CubeSet& cube_set, const string& name) {
+  if (name.length() > cube_set.cubes.size())
+    return false;
+
+  size_t letter_count[256] = {};
+  for (unsigned char symbol : name) {
+    if (++letter_count[symbol] > cube_set.letter_to_cubes[symbol].size())
+      return false;
+  }
+  return true;
+}
+
+// условие Холла для малого набора кубиков
+// позиции имени с одной буквой имеют одинаковых соседей, поэтому достаточно перебрать
+// подмножества S различных букв: сумма их кратностей не больше числа кубиков хотя бы с одной из них
+// условие необходимо и достаточно, так что при true паросочетание заведомо найдется
+// перебор 2^k подмножеств делается только при k <= MaxHallLetters, иначе возвращается true
+bool hall_condition_holds(const CubeSet& cube_set, const string& name) {
+  const int MaxHallLetters = 6;
+
+  int letter_count[256] = {};
+  for (unsigned char symbol : name)
+    letter_count[symbol]++;
+
+  vector<int> letters;
+  for (int symbol = 0; symbol < 256; ++symbol) {
+    if (letter_count[symbol] > 0)
+      letters.push_back(symbol);
+  }
+  if (letters.size() > MaxHallLetters)
+    return true;
+
+  // need[S] и cover[S] считаются из S без младшей буквы
+  const size_t subsets = size_t(1) << letters.size();
+  int need[1 << MaxHallLetters];
+  Mask256 cover[1 << MaxHallLetters];
+  need[0] = 0;
+  for (size_t s = 1; s < subsets; ++s) {
+    const size_t rest = s & (s - 1);
+    const int letter = letters[__builtin_ctzll(s)];
+    need[s] = need[rest] + letter_count[letter];
+    cover[s] = cover[rest] | cube_set.letter_cubes[letter];
+    if (need[s] > cover[s].count())
+      return false;
+  }
+  return true;
+}
+
+// паросочетание на масках для малого набора кубиков (алгоритм Куна с BFS):
+// кандидаты из позиции - одна операция AND маски кубиков буквы с маской непосещенных,
+// свободный кубик среди них находится через ctz
+bool match_with_masks(const CubeSet& cube_set, const string& name, vector<int>& assignment) {
+  const int NameLength = name.length();
+  assignment.assign(NameLength, -1);
+
+  int cube_owner[CubeSet::MaskCubes]; // cube_owner[кубик] - позиция имени или -1
+  fill(cube_owner, cube_owner + CubeSet::MaskCubes, -1);
+
+  Mask256 free_cubes;
+  for (size_t i = 0; i < cube_set.cubes.size(); ++i)
+    free_cubes.set(i);
+
+  vector<int> queue(NameLength);
+  vector<int> parent(NameLength); // позиция, из которой пришли в данную по ее кубику
+
+  for (int root = 0; root < NameLength; ++root) {
+    Mask256 unvisited = ~Mask256();
+    int head = 0, tail = 0;
+    queue[tail++] = root;
+    parent[root] = -1;
+
+    int found_position = -1, found_cube = -1;
+    while (head < tail && found_cube == -1) {
+      const int position = queue[head++];
+      const Mask256 candidates = cube_set.letter_cubes[(unsigned char)name[position]] & unvisited;
+      unvisited = unvisited & ~candidates;
+
+      const Mask256 free_candidates = candidates & free_cubes;
+      if (free_candidates.any()) {
+        found_position = position;
+        found_cube = free_candidates.first();
+        break;
+      }
+      candidates.for_each([&](int cube) {
+        const int owner = cube_owner[cube];
+        parent[owner] = position;
+        queue[tail++] = owner;
+      });
+    }
+
+    if (found_cube == -1)
+      return false;
+
+    // перекладываю кубики вдоль найденного пути к корню
+    free_cubes.words[found_cube >> 6] &= ~(uint64_t(1) << (found_cube & 63));
+    for (int position = found_position, cube = found_cube; position != -1;) {
+      const int previous_cube = assignment[position];
+      assignment[position] = cube;
+      cube_owner[cube] = position;
+      cube = previous_cube;
+      position = parent[position];
+    }
+  }
+  return true;
+}
+
+bool match_with_hopcroft_karp(const CubeSet& cube_set, const string& name, vector<int>& assignment) {
+  const size_t NameLength = name.length();
+
+  HopcroftKarp matcher(NameLength, cube_set.cubes.size());
+  for (size_t i = 0; i < NameLength; ++i) {
+    for (int cube : cube_set.letter_to_cubes[(unsigned char)name[i]])
+      matcher.add_edge(i, cube);
+  }
+
+  if (matcher.max_matching() != (int)NameLength)
+    return false;
+  assignment = matcher.match_left;
+  return true;
+}
+
+void solve_with_matching(const CubeSet& cube_set, const string& name, ostream& ofst) {
+  const size_t NameLength = name.length();
+
+  vector<int> assignment;
+  bool found;
+  if (!letters_fit(cube_set, name))
+    found = false;
+  else if (cube_set.is_small())
+    found = hall_condition_holds(cube_set, name) && match_with_masks(cube_set, name, assignment);
+  else
+    found = match_with_hopcroft_karp(cube_set, name, assignment);
+
+  if (found) {
+    ofst << "YES" << endl;
+    for (size_t i = 0; i < NameLength; ++i) {
+      if (i > 0)
+        ofst << ' ';
+      // +1 так как номерация кубиков начинается с 1
+      ofst << (assignment[i] + 1);
+    }
+  }
+  else {
+    ofst << "NO";
+  }
+}
+
+// запрос потокового режима; подряд идущие запросы с одинаковыми кубиками делят один CubeSet
+struct Query {
+  shared_ptr<const CubeSet> cube_set;
+  string name;
+};
+
+// решает пачку запросов на нескольких потоках и выводит ответы в исходном порядке
+void solve_batch(const vector<Query>& batch, ostream& out) {
+  vector<string> answers(batch.size());
+  atomic<size_t> next_query(0);
+
+  auto worker = [&]() {
+    ostringstream answer;
+    for (size_t i = next_query++; i < batch.size(); i = next_query++) {
+      answer.str("");
+      solve_with_matching(*batch[i].cube_set, batch[i].name, answer);
+      answers[i] = answer.str();
+    }
+  };
+
+  const size_t thread_count = min<size_t>(max(1u, thread::hardware_concurrency()), batch.size());
+  vector<thread> threads;
+  for (size_t t = 1; t < thread_count; ++t)
+    threads.emplace_back(worker);
+  worker();
+  for (auto& t : threads)
+    t.join();
+
+  for (auto& answer : answers)
+    out << answer << '\n';
+  out.flush();
+}
+
+// потоковый режим: экземпляры задачи в том же формате, что и input.txt, идут подряд
+// (n, имя, n кубиков), ответы выводятся по мере обработки пачек
+// false - вход оборвался или испорчен; ответы на предыдущие полные запросы уже выведены
+bool run_stream(istream& in, ostream& out) {
+  const size_t BatchSize = 4096;
+
+  vector<Query> batch;
+  batch.reserve(BatchSize);
+  shared_ptr<const CubeSet> last_cube_set;
+
+  size_t n;
+  string name;
+  vector<string> cubes;
+  bool ok = true;
+  while (in >> n >> name) {
+    cubes.assign(n, string());
+    for (size_t i = 0; i < n; ++i)
+      in >> cubes[i];
+    if (!in) {
+      cerr << "запрос \"" << name << "\": ожидалось кубиков " << n << endl;
+      ok = false;
+      break;
+    }
+
+    // граф со стороны кубиков строится заново, только если набор кубиков сменился
+    if (!last_cube_set || last_cube_set->cubes != cubes)
+      last_cube_set = make_shared<const CubeSet>(cubes);
+    batch.push_back({ last_cube_set, name });
+
+    if (batch.size() == BatchSize) {
+      solve_batch(batch, out);
+      batch.clear();
+    }
+  }
+  if (ok && !in.eof()) {
+    cerr << "неверный формат запроса" << endl;
+    ok = false;
+  }
+  if (!batch.empty())
+    solve_batch(batch, out);
+  return ok;
+}
+
+int main(int argc, char* argv[]) {
+  const string mode = argc > 1 ? argv[1] : "";
+
+  // lab7 --stream [файл] - много запросов из файла или stdin, ответы в stdout
+  if (mode == "--stream") {
+    ios::sync_with_stdio(false);
+    if (argc > 2) {
+      ifstream in(argv[2]);
+      if (!in) {
+        cerr << "не удалось открыть " << argv[2] << endl;
+        return 1;
+      }
+      return run_stream(in, cout) ? 0 : 1;
+    }
+    return run_stream(cin, cout) ? 0 : 1;
+  }
+
+  ifstream ifst("input.txt");
+  ofstream ofst("output.txt");
+
+  size_t n;
+  string name;
+  ifst >> n;
+  ifst >> name;
+
+  vector<string> cubes(n);
+  for (size_t i = 0; i < n; ++i)
+    ifst >> cubes[i];
+
+  if (mode == "--flow")
+    solve_with_flow(name, cubes, ofst);
+  else
+    solve_with_matching(CubeSet(move(cubes)), name, ofst);
+}
@@ -1,8 +1,237 @@
 #include <iostream>
 #include <queue>
 #include <algorithm>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 
-int main() {
+// Узел дерева в том же виде, что и в lab1
+struct TreeNode {
+    int id;
+    double x, y;
+    TreeNode* left;
+    TreeNode* right;
+
+    TreeNode(int id_val, double x_val, double y_val)
+        : id(id_val), x(x_val), y(y_val), left(nullptr), right(nullptr) {}
+};
+
+// Кольцевой буфер с ёмкостью-степенью двойки: в отличие от std::queue (deque),
+// память выделяется одним блоком и переиспользуется между обходами
+template <typename T>
+class RingBuffer {
+    std::vector<T> data;
+    size_t head = 0;
+    size_t count = 0;
+
+    void grow() {
+        std::vector<T> bigger(data.empty() ? 16 : data.size() * 2);
+        for (size_t i = 0; i < count; i++) bigger[i] = data[(head + i) & (data.size() - 1)];
+        data.swap(bigger);
+        head = 0;
+    }
+
+public:
+    void push(const T& value) {
+        if (count == data.size()) grow();
+        data[(head + count) & (data.size() - 1)] = value;
+        count++;
+    }
+
+    T pop() {
+        T value = data[head];
+        head = (head + 1) & (data.size() - 1);
+        count--;
+        return value;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    void clear() {
+        head = count = 0;
+    }
+};
+
+// Отзеркаливание на месте обходом в ширину: за итерацию обрабатывается весь текущий уровень
+void mirrorBFS(TreeNode* root, RingBuffer<TreeNode*>& buffer) {
+    buffer.clear();
+    if (root) buffer.push(root);
+    while (!buffer.empty()) {
+        for (size_t levelSize = buffer.size(); levelSize > 0; levelSize--) {
+            TreeNode* node = buffer.pop();
+            std::swap(node->left, node->right);
+            if (node->left) buffer.push(node->left);
+            if (node->right) buffer.push(node->right);
+        }
+    }
+}
+
+void mirrorBFS(TreeNode* root) {
+    RingBuffer<TreeNode*> buffer;
+    mirrorBFS(root, buffer);
+}
+
+// Параллельное отзеркаливание по уровням: каждый поток меняет местами детей в своём куске
+// уровня и собирает свою часть следующего уровня; части склеиваются в исходном порядке.
+// Узлы одного уровня независимы, поэтому синхронизация нужна только между уровнями.
+void mirrorParallel(TreeNode* root, unsigned threads) {
+    const size_t MIN_PARALLEL_LEVEL = 1 << 14;
+    if (threads == 0) threads = 1;
+
+    std::vector<TreeNode*> level, next;
+    std::vector<std::vector<TreeNode*>> parts(threads);
+    if (root) level.push_back(root);
+
+    auto process = [](TreeNode* const* begin, TreeNode* const* end, std::vector<TreeNode*>& out) {
+        for (; begin != end; ++begin) {
+            TreeNode* node = *begin;
+            std::swap(node->left, node->right);
+            if (node->left) out.push_back(node->left);
+            if (node->right) out.push_back(node->right);
+        }
+    };
+
+    while (!level.empty()) {
+        next.clear();
+        if (threads == 1 || level.size() < MIN_PARALLEL_LEVEL) {
+            process(level.data(), level.data() + level.size(), next);
+        } else {
+            std::vector<std::thread> workers;
+            size_t chunk = (level.size() + threads - 1) / threads;
+            for (unsigned t = 0; t < threads; t++) {
+                size_t from = std::min(level.size(), t * chunk);
+                size_t to = std::min(level.size(), from + chunk);
+                parts[t].clear();
+                workers.emplace_back(process, level.data() + from, level.data() + to, std::ref(parts[t]));
+            }
+            for (std::thread& worker : workers) worker.join();
+            for (const std::vector<TreeNode*>& part : parts) next.insert(next.end(), part.begin(), part.end());
+        }
+        level.swap(next);
+    }
+}
+
+// Рекурсивный вариант - только для сравнения в бенчмарке
+void mirrorRecursive(TreeNode* node) {
+    if (!node) return;
+    std::swap(node->left, node->right);
+    mirrorRecursive(node->left);
+    mirrorRecursive(node->right);
+}
+
+// Вывод ID в порядке обхода по уровням, уровни разделяются " | "
+void printLevelOrder(TreeNode* root, std::ostream& out) {
+    RingBuffer<TreeNode*> buffer;
+    if (root) buffer.push(root);
+    bool firstLevel = true;
+    while (!buffer.empty()) {
+        if (!firstLevel) out << " | ";
+        firstLevel = false;
+        for (size_t levelSize = buffer.size(), i = 0; i < levelSize; i++) {
+            TreeNode* node = buffer.pop();
+            if (i > 0) out << ' ';
+            out << node->id;
+            if (node->left) buffer.push(node->left);
+            if (node->right) buffer.push(node->right);
+        }
+    }
+    out << "\n";
+}
+
+// Сбалансированное дерево с ID 1..n без рекурсии
+TreeNode* buildBalanced(int n) {
+    struct Range {
+        int lo, hi;
+        TreeNode** slot;
+    };
+    TreeNode* root = nullptr;
+    std::vector<Range> stack = {{1, n, &root}};
+    while (!stack.empty()) {
+        Range r = stack.back();
+        stack.pop_back();
+        if (r.lo > r.hi) continue;
+        int mid = r.lo + (r.hi - r.lo) / 2;
+        TreeNode* node = new TreeNode(mid, mid * 0.5, mid * 0.25);
+        *r.slot = node;
+        stack.push_back({r.lo, mid - 1, &node->left});
+        stack.push_back({mid + 1, r.hi, &node->right});
+    }
+    return root;
+}
+
+void deleteTree(TreeNode* root) {
+    std::vector<TreeNode*> stack;
+    if (root) stack.push_back(root);
+    while (!stack.empty()) {
+        TreeNode* node = stack.back();
+        stack.pop_back();
+        if (node->left) stack.push_back(node->left);
+        if (node->right) stack.push_back(node->right);
+        delete node;
+    }
+}
+
+// Контрольная сумма формы: ID в порядке обхода по уровням с весами позиций
+uint64_t shapeHash(TreeNode* root) {
+    RingBuffer<TreeNode*> buffer;
+    uint64_t hash = 0;
+    if (root) buffer.push(root);
+    while (!buffer.empty()) {
+        TreeNode* node = buffer.pop();
+        hash = hash * 1000003 + (uint64_t)node->id;
+        if (node->left) buffer.push(node->left);
+        if (node->right) buffer.push(node->right);
+    }
+    return hash;
+}
+
+void runBenchmark(int n, unsigned threads) {
+    using Clock = std::chrono::steady_clock;
+    TreeNode* root = buildBalanced(n);
+    uint64_t original = shapeHash(root);
+    RingBuffer<TreeNode*> buffer;
+
+    auto measure = [&](const std::string& name, auto mirror) {
+        // Два отзеркаливания подряд возвращают исходное дерево
+        auto start = Clock::now();
+        mirror();
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        mirror();
+        std::cout << name << ": " << ms << " мс" << (shapeHash(root) == original ? "" : " (ОШИБКА)") << "\n";
+    };
+
+    std::cout << "Дерево из " << n << " узлов, потоков: " << threads << "\n";
+    measure("Рекурсивное", [&] { mirrorRecursive(root); });
+    measure("BFS с кольцевым буфером", [&] { mirrorBFS(root, buffer); });
+    measure("Параллельное по уровням", [&] { mirrorParallel(root, threads); });
+    deleteTree(root);
+}
+
+// test            - отзеркаливание небольшого дерева с выводом по уровням
+// test --bench [n] [потоки] - сравнение вариантов на дереве из n узлов (по умолчанию 10^7)
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && std::string(argv[1]) == "--bench") {
+        int n = argc >= 3 ? std::atoi(argv[2]) : 10000000;
+        unsigned threads = argc >= 4 ? (unsigned)std::atoi(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+        runBenchmark(n, threads);
+        return 0;
+    }
+
+    TreeNode* root = buildBalanced(10);
+    std::cout << "Исходное дерево (BFS): ";
+    printLevelOrder(root, std::cout);
+    mirrorBFS(root);
     std::cout << "После отзеркаливания (BFS): ";
+    printLevelOrder(root, std::cout);
+    deleteTree(root);
     return 0;
-}
\ No newline at end of file
+}